@@ -11,9 +11,56 @@
 
 #include <config.h>
 #include <cups/cups.h>
+#include <cups/thread.h>
 #include <errno.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+//
+// Local constants...
+//
+
+#define LP_BUFFER	262144		// Size of read buffer
+#define LP_CHUNK	1048576		// Size of each write from a mapped file
+#define LP_MAX_JOBS	4		// Maximum number of concurrent jobs
+
+
+//
+// Local types...
+//
+
+typedef struct lp_doc_s			// Document file
+{
+  int		fd;			// File descriptor
+  char		*map;			// Mapped file or `NULL`
+  size_t	mapsize,		// Size of mapped file
+		mapoffset;		// Offset in mapped file
+  char		*buffer;		// Read buffer
+} lp_doc_t;
+
+typedef struct lp_gzip_s		// Document compression data
+{
+  lp_doc_t	*doc;			// Document file
+  int		fd;			// Pipe for compressed data
+} lp_gzip_t;
+
+typedef struct lp_split_s		// Per-file job data
+{
+  cups_mutex_t	mutex;			// Mutex for next_file
+  const char	*command;		// Command name
+  cups_dest_t	*dest;			// Destination
+  size_t	num_files,		// Number of files
+		next_file;		// Next file to print
+  const char	**files;		// Files
+  const char	*title;			// Title or `NULL` for the file name
+  size_t	num_options;		// Number of options
+  cups_option_t	*options;		// Options
+  bool		compress;		// Compress document data?
+  int		*job_ids;		// Job ID for each file
+} lp_split_t;
 
 
 //
@@ -21,9 +68,16 @@
 //
 
 static http_t		*connect_dest(const char *command, const char *printer, const char *instance, cups_dest_t **dest, cups_dinfo_t **dinfo, char *resource, size_t resourcesize);
-static int		print_files(const char *command, http_t *http, cups_dest_t *dest, cups_dinfo_t *dinfo, size_t num_files, const char **files, const char *title, size_t num_options, cups_option_t *options);
-static int		send_document(const char *command, http_t *http, cups_dest_t *dest, cups_dinfo_t *dinfo, int job_id, const char *docname, const char *format, bool last_document, int fd);
+static void		doc_close(lp_doc_t *doc);
+static bool		doc_open(lp_doc_t *doc, int fd);
+static ssize_t		doc_read(lp_doc_t *doc, const char **data);
+static void		*gzip_document(lp_gzip_t *gzip);
+static int		open_file(const char *command, const char *filename);
+static int		print_files(const char *command, http_t *http, cups_dest_t *dest, cups_dinfo_t *dinfo, size_t num_files, const char **files, const char *title, size_t num_options, cups_option_t *options, bool compress);
+static void		print_split(lp_split_t *split);
+static int		send_document(const char *command, http_t *http, cups_dest_t *dest, cups_dinfo_t *dinfo, int job_id, const char *docname, const char *format, bool last_document, bool compress, int fd);
 static int		set_job_attrs(const char *command, http_t *http, cups_dest_t *dest, cups_dinfo_t *dinfo, const char *resource, int job_id, int num_options, cups_option_t *options);
+static void		*split_worker(lp_split_t *split);
 static int		usage(FILE *out, const char *command);
 
 
@@ -59,7 +113,12 @@ main(int  argc,				// I - Number of command-line arguments
   cups_option_t	*options = NULL;	// Options
   bool		end_options = false,	// No more options?
 		silent = false,		// Silent or verbose output?
-		deletefile = false;	// Delete file after submission?
+		deletefile = false,	// Delete file after submission?
+		compress = false,	// Compress document data?
+		have_title = false,	// Was a title specified?
+		per_file = false;	// Submit a job for each file?
+  const char	*compression,		// "compression" option
+		*job_split;		// "job-split" option
 
 
   // Get command name...
@@ -350,7 +409,8 @@ main(int  argc,				// I - Number of command-line arguments
 	  case 't' : // -t TITLE   Set job name
 	      if (opt[1] != '\0')
 	      {
-		title = opt + 1;
+		title      = opt + 1;
+		have_title = true;
 		opt += strlen(opt) - 1;
 	      }
 	      else
@@ -363,7 +423,8 @@ main(int  argc,				// I - Number of command-line arguments
 		  return (usage(stderr, command));
 		}
 
-		title = argv[i];
+		title      = argv[i];
+		have_title = true;
 	      }
 	      break;
 
@@ -442,15 +503,97 @@ main(int  argc,				// I - Number of command-line arguments
       num_options = cupsAddOption(dest->options[idx].name, dest->options[idx].value, num_options, &options);
   }
 
+  // Compress documents?  The "compression" option only applies to the
+  // document data, so it is not sent with the job attributes...
+  if ((compression = cupsGetOption("compression", num_options, options)) != NULL)
+  {
+    if (!strcmp(compression, "auto"))
+    {
+      compress = cupsCheckDestSupported(http, dest, dinfo, "compression", "gzip");
+    }
+    else if (!strcmp(compression, "gzip"))
+    {
+      compress = true;
+    }
+    else if (strcmp(compression, "none"))
+    {
+      cupsLangPrintf(stderr, _("%s: Unsupported compression '%s'."), command, compression);
+      return (1);
+    }
+
+    num_options = cupsRemoveOption("compression", num_options, &options);
+  }
+
+  // Submit a separate job for each file?
+  if ((job_split = cupsGetOption("job-split", num_options, options)) != NULL)
+  {
+    if (!strcmp(job_split, "per-file"))
+    {
+      per_file = true;
+    }
+    else if (strcmp(job_split, "none"))
+    {
+      cupsLangPrintf(stderr, _("%s: Unsupported job-split '%s'."), command, job_split);
+      return (1);
+    }
+
+    num_options = cupsRemoveOption("job-split", num_options, &options);
+  }
+
   // Process things...
   if (job_id)
   {
     // Update options for an existing job...
     return (set_job_attrs(command, http, dest, dinfo, resource, job_id, num_options, options));
   }
+  else if (num_files > 1 && per_file)
+  {
+    // Print each file as a separate job...
+    lp_split_t	split;			// Per-file job data
+    int		status = 0;		// Exit status
+
+    memset(&split, 0, sizeof(split));
+
+    split.command     = command;
+    split.dest        = dest;
+    split.num_files   = num_files;
+    split.files       = files;
+    split.title       = have_title ? title : NULL;
+    split.num_options = num_options;
+    split.options     = options;
+    split.compress    = compress;
+
+    if ((split.job_ids = calloc(num_files, sizeof(int))) == NULL)
+    {
+      cupsLangPrintf(stderr, _("%s: %s"), command, strerror(errno));
+      return (1);
+    }
+
+    print_split(&split);
+
+    for (idx = 0; idx < num_files; idx ++)
+    {
+      if (split.job_ids[idx] > 0)
+      {
+        if (!silent)
+          cupsLangPrintf(stdout, _("request id is %s-%d (%d file(s))"), dest->name, split.job_ids[idx], 1);
+
+        if (deletefile)
+          unlink(files[idx]);
+      }
+      else
+      {
+        status = 1;
+      }
+    }
+
+    free(split.job_ids);
+
+    return (status);
+  }
   else if (num_files > 0)
   {
-    job_id = print_files(command, http, dest, dinfo, num_files, files, title, num_options, options);
+    job_id = print_files(command, http, dest, dinfo, num_files, files, title, num_options, options, compress);
 
     if (job_id && deletefile)
     {
@@ -465,7 +608,7 @@ main(int  argc,				// I - Number of command-line arguments
   }
   else
   {
-    if (send_document(command, http, dest, dinfo, job_id, /*docname*/NULL, cupsGetOption("document-format", num_options, options), /*last_document*/true, 0))
+    if (send_document(command, http, dest, dinfo, job_id, /*docname*/NULL, cupsGetOption("document-format", num_options, options), /*last_document*/true, compress, 0))
       job_id = 0;
   }
 
@@ -527,6 +670,148 @@ connect_dest(const char   *command,	// I - Command name
 }
 
 
+//
+// 'doc_close()' - Close a document file.
+//
+// The file descriptor is left open for the caller.
+//
+
+static void
+doc_close(lp_doc_t *doc)		// I - Document file
+{
+  if (doc->map)
+    munmap(doc->map, doc->mapsize);
+
+  free(doc->buffer);
+}
+
+
+//
+// 'doc_open()' - Prepare to read a document file.
+//
+
+static bool				// O - `true` on success, `false` on error
+doc_open(lp_doc_t *doc,			// I - Document file
+         int      fd)			// I - File descriptor
+{
+  struct stat	fileinfo;		// File information
+
+
+  memset(doc, 0, sizeof(lp_doc_t));
+  doc->fd = fd;
+
+  // Map regular files so they can be sent without copying...
+  if (!fstat(fd, &fileinfo) && S_ISREG(fileinfo.st_mode) && fileinfo.st_size > 0 && lseek(fd, 0, SEEK_CUR) == 0)
+  {
+    if ((doc->map = mmap(NULL, (size_t)fileinfo.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) != MAP_FAILED)
+    {
+      doc->mapsize = (size_t)fileinfo.st_size;
+      madvise(doc->map, doc->mapsize, MADV_SEQUENTIAL);
+      return (true);
+    }
+
+    doc->map = NULL;
+  }
+
+  // Otherwise read the file in large chunks...
+  return ((doc->buffer = malloc(LP_BUFFER)) != NULL);
+}
+
+
+//
+// 'doc_read()' - Read the next chunk of a document file.
+//
+
+static ssize_t				// O - Number of bytes, 0 on EOF, -1 on error
+doc_read(lp_doc_t   *doc,		// I - Document file
+         const char **data)		// O - Pointer to data
+{
+  ssize_t	bytes;			// Bytes read
+
+
+  if (doc->map)
+  {
+    if ((bytes = (ssize_t)(doc->mapsize - doc->mapoffset)) > LP_CHUNK)
+      bytes = LP_CHUNK;
+
+    *data = doc->map + doc->mapoffset;
+    doc->mapoffset += (size_t)bytes;
+  }
+  else
+  {
+    while ((bytes = read(doc->fd, doc->buffer, LP_BUFFER)) < 0 && (errno == EINTR || errno == EAGAIN));
+
+    *data = doc->buffer;
+  }
+
+  return (bytes);
+}
+
+
+//
+// 'gzip_document()' - Compress a document file into a pipe.
+//
+
+static void *				// O - `NULL` on success, non-`NULL` on error
+gzip_document(lp_gzip_t *gzip)		// I - Compression data
+{
+  cups_file_t	*fp;			// Compressed output
+  const char	*data;			// Document data
+  ssize_t	bytes;			// Bytes read
+  bool		ret = true;		// Return value
+
+
+  if ((fp = cupsFileOpenFd(gzip->fd, "w6")) == NULL)
+  {
+    close(gzip->fd);
+    return (gzip);
+  }
+
+  while ((bytes = doc_read(gzip->doc, &data)) > 0)
+  {
+    if (!cupsFileWrite(fp, data, (size_t)bytes))
+    {
+      ret = false;
+      break;
+    }
+  }
+
+  if (bytes < 0)
+    ret = false;
+
+  if (!cupsFileClose(fp))
+    ret = false;
+
+  return (ret ? NULL : gzip);
+}
+
+
+//
+// 'open_file()' - Open a print file and start reading it.
+//
+
+static int				// O - File descriptor or -1 on error
+open_file(const char *command,		// I - Command name
+          const char *filename)		// I - File to open
+{
+  int	fd;				// File descriptor
+
+
+  if ((fd = open(filename, O_RDONLY)) < 0)
+  {
+    cupsLangPrintf(stderr, _("%s: Unable to open '%s': %s"), command, filename, strerror(errno));
+    return (-1);
+  }
+
+#ifdef POSIX_FADV_WILLNEED
+  // Start reading the file in the background...
+  posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+#endif // POSIX_FADV_WILLNEED
+
+  return (fd);
+}
+
+
 //
 // 'print_files()' - Print one or more files to the specified destination...
 //
@@ -540,10 +825,12 @@ print_files(const char    *command,	// I - Command name
             const char    **files,	// I - Files
             const char    *title,	// I - Title
             size_t        num_options,	// I - Number of options
-            cups_option_t *options)	// I - Options
+            cups_option_t *options,	// I - Options
+            bool          compress)	// I - Compress document data?
 {
   size_t	i;			// Looping var...
-  int		job_id;			// Job ID
+  int		job_id,			// Job ID
+		fd;			// Current print file
 
 
   if (cupsCreateDestJob(http, dest, dinfo, &job_id, title, num_options, options) >= IPP_STATUS_ERROR_BAD_REQUEST)
@@ -552,15 +839,23 @@ print_files(const char    *command,	// I - Command name
     return (0);
   }
 
+  if ((fd = open_file(command, files[0])) < 0)
+  {
+    cupsCancelDestJob(http, dest, job_id);
+    return (0);
+  }
+
   for (i = 0; i < num_files; i ++)
   {
-    int		fd;			// Print file
+    int		next_fd = -1;		// Next print file
     const char	*docname;		// Document name
     int		status;			// Send status
 
-    if ((fd = open(files[i], O_RDONLY)) < 0)
+    // Open the next file now so the kernel can read it while this one is
+    // being sent...
+    if ((i + 1) < num_files && (next_fd = open_file(command, files[i + 1])) < 0)
     {
-      cupsLangPrintf(stderr, _("%s: Unable to open '%s': %s"), command, files[i], strerror(errno));
+      close(fd);
       cupsCancelDestJob(http, dest, job_id);
       return (0);
     }
@@ -570,12 +865,16 @@ print_files(const char    *command,	// I - Command name
     else
       docname = files[i];
 
-    status = send_document(command, http, dest, dinfo, job_id, docname, cupsGetOption("document-format", num_options, options), i == (num_files - 1), fd);
+    status = send_document(command, http, dest, dinfo, job_id, docname, cupsGetOption("document-format", num_options, options), i == (num_files - 1), compress, fd);
 
     close(fd);
+    fd = next_fd;
 
     if (status)
     {
+      if (fd >= 0)
+        close(fd);
+
       cupsCancelDestJob(http, dest, job_id);
       return (0);
     }
@@ -585,9 +884,51 @@ print_files(const char    *command,	// I - Command name
 }
 
 
+//
+// 'print_split()' - Print each file as a separate job.
+//
+// Up to LP_MAX_JOBS threads submit the jobs, each over its own connection.
+//
+
+static void
+print_split(lp_split_t *split)		// I - Per-file job data
+{
+  size_t	i,			// Looping var
+		num_threads;		// Number of threads
+  cups_thread_t	threads[LP_MAX_JOBS];	// Threads
+
+
+  cupsMutexInit(&split->mutex);
+
+  if ((num_threads = split->num_files) > LP_MAX_JOBS)
+    num_threads = LP_MAX_JOBS;
+
+  for (i = 0; i < num_threads; i ++)
+  {
+    if ((threads[i] = cupsThreadCreate((cups_thread_func_t)split_worker, split)) == CUPS_THREAD_INVALID)
+      break;
+  }
+
+  if ((num_threads = i) == 0)
+  {
+    // No threads, print the files here...
+    split_worker(split);
+  }
+
+  for (i = 0; i < num_threads; i ++)
+    cupsThreadWait(threads[i]);
+
+  cupsMutexDestroy(&split->mutex);
+}
+
+
 //
 // 'send_document()' - Send a single document for printing.
 //
+// Regular files are mapped into memory and sent in large chunks, anything
+// else is read through a large buffer.  When "compress" is `true` the data
+// is compressed with gzip by a separate thread as it is sent.
+//
 
 static int				// O - Exit status
 send_document(
@@ -599,19 +940,89 @@ send_document(
     const char   *docname,		// I - Document name
     const char   *format,		// I - File format
     bool         last_document,		// I - Is this the last document?
+    bool         compress,		// I - Compress document data?
     int          fd)			// I - File to send
 {
   http_status_t	status;			// Write status
-  char		buffer[8192];		// Copy buffer
+  lp_doc_t	doc;			// Document file
+  const char	*data;			// Document data
   ssize_t	bytes;			// Bytes read
+  size_t	num_doptions = 0;	// Number of document options
+  cups_option_t	*doptions = NULL;	// Document options
 
 
+  if (!doc_open(&doc, fd))
+  {
+    cupsLangPrintf(stderr, _("%s: %s"), command, strerror(errno));
+    cupsCancelDestJob(http, dest, job_id);
+    return (1);
+  }
+
   // Start sending another document...
-  status = cupsStartDestDocument(http, dest, dinfo, job_id, docname, format, /*num_options*/0, /*options*/NULL, last_document);
+  if (compress)
+    num_doptions = cupsAddOption("compression", "gzip", num_doptions, &doptions);
+
+  status = cupsStartDestDocument(http, dest, dinfo, job_id, docname, format, num_doptions, doptions, last_document);
+
+  cupsFreeOptions(num_doptions, doptions);
 
   // Copy the document to the job...
-  while (status == HTTP_STATUS_CONTINUE && (bytes = read(fd, buffer, sizeof(buffer))) > 0)
-    status = cupsWriteRequestData(http, buffer, (size_t)bytes);
+  if (compress && status == HTTP_STATUS_CONTINUE)
+  {
+    int			fds[2];		// Pipe for compressed data
+    lp_gzip_t		gzip;		// Compression data
+    cups_thread_t	tid;		// Compression thread
+    char		buffer[65536];	// Compressed data buffer
+
+    if (pipe(fds))
+    {
+      status = HTTP_STATUS_ERROR;
+    }
+    else
+    {
+      gzip.doc = &doc;
+      gzip.fd  = fds[1];
+
+      if ((tid = cupsThreadCreate((cups_thread_func_t)gzip_document, &gzip)) == CUPS_THREAD_INVALID)
+      {
+        close(fds[0]);
+        close(fds[1]);
+        status = HTTP_STATUS_ERROR;
+      }
+      else
+      {
+        // Keep reading until the thread is done, even after an error...
+        while ((bytes = read(fds[0], buffer, sizeof(buffer))) != 0)
+        {
+          if (bytes < 0)
+          {
+            if (errno == EINTR || errno == EAGAIN)
+              continue;
+
+            status = HTTP_STATUS_ERROR;
+            break;
+          }
+          else if (status == HTTP_STATUS_CONTINUE)
+          {
+            status = cupsWriteRequestData(http, buffer, (size_t)bytes);
+          }
+        }
+
+        // Closing the pipe stops the thread if we gave up early...
+        close(fds[0]);
+
+        if (cupsThreadWait(tid) != NULL)
+          status = HTTP_STATUS_ERROR;
+      }
+    }
+  }
+  else
+  {
+    while (status == HTTP_STATUS_CONTINUE && (bytes = doc_read(&doc, &data)) > 0)
+      status = cupsWriteRequestData(http, data, (size_t)bytes);
+  }
+
+  doc_close(&doc);
 
   // Finish up...
   if (status != HTTP_STATUS_CONTINUE)
@@ -679,6 +1090,57 @@ set_job_attrs(
 }
 
 
+//
+// 'split_worker()' - Print files as separate jobs over one connection.
+//
+
+static void *				// O - Thread exit status
+split_worker(lp_split_t *split)		// I - Per-file job data
+{
+  http_t	*http;			// HTTP connection
+  cups_dinfo_t	*dinfo;			// Destination information
+  char		resource[1024];		// Resource path for printer
+  size_t	i;			// Current file
+  const char	*docname;		// Document name
+
+
+  if ((http = cupsConnectDest(split->dest, CUPS_DEST_FLAGS_NONE, 30000, /*cancel*/NULL, resource, sizeof(resource), /*cb*/NULL, /*user_data*/NULL)) == NULL)
+  {
+    cupsLangPrintf(stderr, _("%s: Unable to connect to '%s': %s"), split->command, split->dest->name, cupsGetErrorString());
+    return (NULL);
+  }
+
+  if ((dinfo = cupsCopyDestInfo(http, split->dest, CUPS_DEST_FLAGS_NONE)) == NULL)
+  {
+    cupsLangPrintf(stderr, _("%s: Unable to get information on '%s': %s"), split->command, split->dest->name, cupsGetErrorString());
+    httpClose(http);
+    return (NULL);
+  }
+
+  for (;;)
+  {
+    cupsMutexLock(&split->mutex);
+    i = split->next_file ++;
+    cupsMutexUnlock(&split->mutex);
+
+    if (i >= split->num_files)
+      break;
+
+    if ((docname = strrchr(split->files[i], '/')) != NULL)
+      docname ++;
+    else
+      docname = split->files[i];
+
+    split->job_ids[i] = print_files(split->command, http, split->dest, dinfo, 1, split->files + i, split->title ? split->title : docname, split->num_options, split->options, split->compress);
+  }
+
+  cupsFreeDestInfo(dinfo);
+  httpClose(http);
+
+  return (NULL);
+}
+
+
 //
 // 'usage()' - Show program usage and exit.
 //
@@ -713,7 +1175,9 @@ usage(FILE       *out,			// I - Output file
   if (!strcmp(command, "lp"))
     cupsLangPuts(out, _("-n COPIES                      Specify the number of copies to print"));
   cupsLangPuts(out, _("-o OPTION[=VALUE]              Specify a printer-specific option"));
+  cupsLangPuts(out, _("-o compression=auto            Compress the document data if the printer supports it"));
   cupsLangPuts(out, _("-o job-sheets=standard         Print a banner page with the job"));
+  cupsLangPuts(out, _("-o job-split=per-file          Print each file as a separate job"));
   cupsLangPuts(out, _("-o media=SIZE                  Specify the media size to use"));
   cupsLangPuts(out, _("-o number-up=N                 Specify that input pages should be printed N-up (1, 2, 4, 6, 9, and 16 are supported)"));
   cupsLangPuts(out, _("-o orientation-requested=N     Specify portrait (3) or landscape (4) orientation"));
@@ -14,15 +14,27 @@
 #include <ctype.h>
 
 
+//
+// Local constants...
+//
+
+#define LPQ_LEASE_DURATION	3600	// Subscription lease in seconds
+
+
 //
 // Local functions...
 //
 
+static void	add_target(ipp_t *, const char *);
+static void	cancel_subscription(http_t *, const char *, int);
 static http_t	*connect_server(const char *, http_t *);
+static int	create_subscription(http_t *, const char *);
+static int	get_notifications(http_t *, const char *, int, int *);
 static int	show_jobs(const char *, http_t *, const char *,
 		          const char *, const int, const int);
 static void	show_printer(const char *, http_t *, const char *);
 static void	usage(void) _CUPS_NORETURN;
+static bool	wait_cb(http_t *, void *);
 
 
 //
@@ -43,7 +55,11 @@ main(int  argc,				// I - Number of command-line arguments
   int		id,			// Desired job ID
 		all,			// All printers
 		interval,		// Reporting interval
-		longstatus;		// Show file details
+		longstatus,		// Show file details
+		sub_id = 0,		// Subscription ID
+		sub_seq = 1,		// Next notification sequence number
+		events;			// Number of events
+  time_t	last;			// Time of last report
   cups_dest_t	*named_dest;		// Named destination
 
 
@@ -249,32 +265,108 @@ main(int  argc,				// I - Number of command-line arguments
   * Show the status in a loop...
   */
 
+  if (interval > 0)
+    sub_id = create_subscription(http, dest);
+
   for (;;)
   {
     if (dest)
       show_printer(argv[0], http, dest);
 
-    i = show_jobs(argv[0], http, dest, user, id, longstatus);
+    i    = show_jobs(argv[0], http, dest, user, id, longstatus);
+    last = time(NULL);
+
+    if (!i || !interval)
+      break;
+
+    fflush(stdout);
 
-    if (i && interval)
+    if (sub_id > 0)
     {
-      fflush(stdout);
-      sleep((unsigned)interval);
+     /*
+      * Wait for a job or printer state change, then wait out the rest of the
+      * interval so that a burst of events produces a single report...
+      */
+
+      while ((events = get_notifications(http, dest, sub_id, &sub_seq)) == 0);
+
+      if (events < 0)
+      {
+       /*
+        * The subscription has expired or the server can't hold the request,
+	* so try a new one and fall back to polling...
+	*/
+
+        if ((sub_id = create_subscription(http, dest)) > 0)
+          sub_seq = 1;
+	else
+	  sleep((unsigned)interval);
+      }
+      else if ((time(NULL) - last) < interval)
+      {
+        sleep((unsigned)(interval - (time(NULL) - last)));
+      }
     }
     else
-      break;
+      sleep((unsigned)interval);
   }
 
  /*
   * Close the connection to the server and return...
   */
 
+  if (sub_id > 0)
+    cancel_subscription(http, dest, sub_id);
+
   httpClose(http);
 
   return (0);
 }
 
 
+//
+// 'add_target()' - Add the printer or system URI to a subscription request.
+//
+
+static void
+add_target(ipp_t      *request,		// I - IPP request
+           const char *dest)		// I - Destination or `NULL` for all
+{
+  char	uri[HTTP_MAX_URI];		// Printer URI
+
+
+  if (dest)
+  {
+    httpAssembleURIf(HTTP_URI_CODING_ALL, uri, sizeof(uri), "ipp", NULL, "localhost", 0, "/ipp/print/%s", dest);
+    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, uri);
+  }
+  else
+    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "system-uri", NULL, "ipp://localhost/ipp/system");
+
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsGetUser());
+}
+
+
+//
+// 'cancel_subscription()' - Cancel the event subscription.
+//
+
+static void
+cancel_subscription(http_t     *http,	// I - HTTP connection to server
+                    const char *dest,	// I - Destination or `NULL` for all
+		    int        sub_id)	// I - Subscription ID
+{
+  ipp_t	*request;			// IPP request
+
+
+  request = ippNewRequest(IPP_OP_CANCEL_SUBSCRIPTION);
+  add_target(request, dest);
+  ippAddInteger(request, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "notify-subscription-id", sub_id);
+
+  ippDelete(cupsDoRequest(http, request, "/"));
+}
+
+
 //
 // 'connect_server()' - Connect to the server as necessary...
 //
@@ -298,6 +390,123 @@ connect_server(const char *command,	// I - Command name
 }
 
 
+//
+// 'create_subscription()' - Subscribe to job and printer state changes.
+//
+// Returns 0 if the server does not support pull ("ippget") subscriptions, in
+// which case "lpq" polls every interval.
+//
+
+static int				// O - Subscription ID or 0 on error
+create_subscription(http_t     *http,	// I - HTTP connection to server
+                    const char *dest)	// I - Destination or `NULL` for all
+{
+  ipp_t		*request,		// IPP request
+		*response;		// IPP response
+  ipp_attribute_t *attr;		// notify-subscription-id attribute
+  int		sub_id = 0;		// Subscription ID
+  static const char * const events[] =	// Events we want to see
+  {
+    "job-completed",
+    "job-created",
+    "job-state-changed",
+    "printer-state-changed"
+  };
+
+
+  request = ippNewRequest(dest ? IPP_OP_CREATE_PRINTER_SUBSCRIPTIONS : IPP_OP_CREATE_SYSTEM_SUBSCRIPTIONS);
+  add_target(request, dest);
+
+  ippAddString(request, IPP_TAG_SUBSCRIPTION, IPP_TAG_KEYWORD, "notify-pull-method", NULL, "ippget");
+  ippAddStrings(request, IPP_TAG_SUBSCRIPTION, IPP_TAG_KEYWORD, "notify-events", sizeof(events) / sizeof(events[0]), NULL, events);
+  ippAddInteger(request, IPP_TAG_SUBSCRIPTION, IPP_TAG_INTEGER, "notify-lease-duration", LPQ_LEASE_DURATION);
+
+  if ((response = cupsDoRequest(http, request, "/")) != NULL)
+  {
+    if (ippGetStatusCode(response) <= IPP_STATUS_OK_CONFLICTING && (attr = ippFindAttribute(response, "notify-subscription-id", IPP_TAG_INTEGER)) != NULL)
+      sub_id = ippGetInteger(attr, 0);
+
+    ippDelete(response);
+  }
+
+  return (sub_id);
+}
+
+
+//
+// 'get_notifications()' - Wait for events from the subscription.
+//
+// The request asks the server to hold the response until an event arrives.
+// If the server answers right away with no events, wait for the interval it
+// suggests (or 1 second) before asking again.
+//
+
+static int				// O - Number of events, 0 for none, -1 on error
+get_notifications(http_t     *http,	// I  - HTTP connection to server
+                  const char *dest,	// I  - Destination or `NULL` for all
+		  int        sub_id,	// I  - Subscription ID
+		  int        *sub_seq)	// IO - Next sequence number
+{
+  ipp_t		*request,		// IPP request
+		*response;		// IPP response
+  ipp_attribute_t *attr;		// Current attribute
+  int		events = 0,		// Number of events
+		get_interval = 0;	// notify-get-interval value
+  time_t	start;			// Start time
+
+
+  request = ippNewRequest(IPP_OP_GET_NOTIFICATIONS);
+  add_target(request, dest);
+
+  ippAddInteger(request, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "notify-subscription-ids", sub_id);
+  ippAddInteger(request, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "notify-sequence-numbers", *sub_seq);
+  ippAddBoolean(request, IPP_TAG_OPERATION, "notify-wait", true);
+
+  // Don't time out while the server holds the request...
+  start = time(NULL);
+
+  httpSetTimeout(http, 30.0, wait_cb, NULL);
+  response = cupsDoRequest(http, request, "/");
+  httpSetTimeout(http, 30.0, NULL, NULL);
+
+  if (!response)
+    return (-1);
+
+  if (ippGetStatusCode(response) > IPP_STATUS_OK_CONFLICTING)
+  {
+    ippDelete(response);
+    return (-1);
+  }
+
+  for (attr = ippGetFirstAttribute(response); attr; attr = ippGetNextAttribute(response))
+  {
+    const char *name = ippGetName(attr);// Attribute name
+
+    if (!name || ippGetValueTag(attr) != IPP_TAG_INTEGER)
+      continue;
+
+    if (!strcmp(name, "notify-get-interval"))
+    {
+      get_interval = ippGetInteger(attr, 0);
+    }
+    else if (!strcmp(name, "notify-sequence-number") && ippGetGroupTag(attr) == IPP_TAG_EVENT_NOTIFICATION)
+    {
+      events ++;
+
+      if (ippGetInteger(attr, 0) >= *sub_seq)
+        *sub_seq = ippGetInteger(attr, 0) + 1;
+    }
+  }
+
+  ippDelete(response);
+
+  if (!events && (time(NULL) - start) < 1)
+    sleep(get_interval > 0 ? (unsigned)get_interval : 1);
+
+  return (events);
+}
+
+
 //
 // 'show_jobs()' - Show jobs.
 //
@@ -634,3 +843,18 @@ usage(void)
 
   exit(1);
 }
+
+
+//
+// 'wait_cb()' - Keep waiting for a held Get-Notifications response.
+//
+
+static bool				// O - `true` to keep waiting
+wait_cb(http_t *http,			// I - HTTP connection to server
+        void   *data)			// I - Callback data (unused)
+{
+  (void)http;
+  (void)data;
+
+  return (true);
+}
@@ -11,6 +11,48 @@
 
 #include <config.h>
 #include <cups/cups.h>
+#include <cups/thread.h>
+
+
+//
+// Local constants...
+//
+
+#define LPSTAT_MAX_CONNS	8	// Maximum connections per query thread
+#define LPSTAT_MAX_THREADS	8	// Maximum number of query threads
+
+
+//
+// Local types...
+//
+
+typedef struct lpstat_conn_s		// Cached connection
+{
+  char		host[256];		// Hostname
+  int		port;			// Port number
+  http_t	*http;			// Connection
+} lpstat_conn_t;
+
+typedef struct lpstat_query_s		// Destination query
+{
+  cups_dest_t	*dest;			// Destination
+  ipp_t		*request,		// IPP request or `NULL` for none
+		*response;		// IPP response
+  char		error[256];		// Connection error message, if any
+  bool		done;			// Has the query completed?
+} lpstat_query_t;
+
+typedef struct lpstat_queries_s		// Pool of destination queries
+{
+  cups_mutex_t	mutex;			// Mutex for pool
+  cups_cond_t	cond;			// Condition for completed queries
+  size_t	num_queries,		// Number of queries
+		next_query;		// Next query to send
+  lpstat_query_t *queries;		// Queries
+  size_t	num_threads;		// Number of query threads
+  cups_thread_t	threads[LPSTAT_MAX_THREADS];
+					// Query threads
+} lpstat_queries_t;
 
 
 //
@@ -18,6 +60,10 @@
 //
 
 static bool	list_dest(bool *long_status, cups_dest_flags_t flags, cups_dest_t *dest);
+static void	query_finish(lpstat_queries_t *pool);
+static void	query_start(lpstat_queries_t *pool, size_t num_queries, lpstat_query_t *queries);
+static lpstat_query_t *query_wait(lpstat_queries_t *pool, size_t n);
+static void	*query_worker(lpstat_queries_t *pool);
 static int	show_accepting(const char *command, size_t num_dests, cups_dest_t *dests, cups_array_t *printers);
 static int	show_classes(const char *command, cups_array_t *printers);
 static void	show_default(const char *command, size_t num_dests, cups_dest_t *dests);
@@ -473,6 +519,201 @@ list_dest(
 }
 
 
+//
+// 'query_finish()' - Wait for the query threads and free the responses.
+//
+
+static void
+query_finish(lpstat_queries_t *pool)	// I - Query pool
+{
+  size_t	i;			// Looping var
+
+
+  for (i = 0; i < pool->num_threads; i ++)
+    cupsThreadWait(pool->threads[i]);
+
+  for (i = 0; i < pool->num_queries; i ++)
+  {
+    ippDelete(pool->queries[i].request);
+    ippDelete(pool->queries[i].response);
+  }
+
+  cupsCondDestroy(&pool->cond);
+  cupsMutexDestroy(&pool->mutex);
+}
+
+
+//
+// 'query_start()' - Start sending queries to destinations.
+//
+// The requests are sent concurrently by up to `LPSTAT_MAX_THREADS` threads.
+// Use `query_wait()` to get the responses in order.
+//
+
+static void
+query_start(
+    lpstat_queries_t *pool,		// I - Query pool
+    size_t           num_queries,	// I - Number of queries
+    lpstat_query_t   *queries)		// I - Queries
+{
+  size_t	i,			// Looping var
+		num_requests;		// Number of requests to send
+  cups_thread_t	thread;			// New thread
+
+
+  memset(pool, 0, sizeof(lpstat_queries_t));
+
+  cupsMutexInit(&pool->mutex);
+  cupsCondInit(&pool->cond);
+
+  pool->num_queries = num_queries;
+  pool->queries     = queries;
+
+  // Queries without a request are already done...
+  for (i = 0, num_requests = 0; i < num_queries; i ++)
+  {
+    if (queries[i].request)
+      num_requests ++;
+    else
+      queries[i].done = true;
+  }
+
+  // Start enough threads to send the requests...
+  while (pool->num_threads < num_requests && pool->num_threads < LPSTAT_MAX_THREADS)
+  {
+    if ((thread = cupsThreadCreate((cups_thread_func_t)query_worker, pool)) == CUPS_THREAD_INVALID)
+      break;
+
+    pool->threads[pool->num_threads ++] = thread;
+  }
+
+  // If we can't start any threads, send the requests now...
+  if (pool->num_threads == 0 && num_requests > 0)
+    query_worker(pool);
+}
+
+
+//
+// 'query_wait()' - Wait for a query to complete.
+//
+
+static lpstat_query_t *			// O - Completed query
+query_wait(lpstat_queries_t *pool,	// I - Query pool
+           size_t           n)		// I - Query number (`0`-based)
+{
+  cupsMutexLock(&pool->mutex);
+  while (!pool->queries[n].done)
+    cupsCondWait(&pool->cond, &pool->mutex, 0.0);
+  cupsMutexUnlock(&pool->mutex);
+
+  return (pool->queries + n);
+}
+
+
+//
+// 'query_worker()' - Send queries to destinations.
+//
+// Connections are kept open and reused for destinations on the same host.
+//
+
+static void *				// O - Thread exit status
+query_worker(lpstat_queries_t *pool)	// I - Query pool
+{
+  size_t	i,			// Looping var
+		num_conns = 0;		// Number of cached connections
+  lpstat_conn_t	conns[LPSTAT_MAX_CONNS];// Cached connections
+  lpstat_query_t *query;		// Current query
+  const char	*uri;			// Printer URI
+  char		scheme[32],		// URI scheme
+		userpass[256],		// URI username:password
+		host[256],		// URI hostname
+		resource[1024];		// Resource path
+  int		port;			// URI port
+  http_t	*http;			// Connection for query
+
+
+  for (;;)
+  {
+    // Get the next query...
+    cupsMutexLock(&pool->mutex);
+    while (pool->next_query < pool->num_queries && pool->queries[pool->next_query].done)
+      pool->next_query ++;
+
+    if (pool->next_query >= pool->num_queries)
+    {
+      cupsMutexUnlock(&pool->mutex);
+      break;
+    }
+
+    query = pool->queries + pool->next_query ++;
+    cupsMutexUnlock(&pool->mutex);
+
+    // Look for an existing connection to the printer's host...
+    http = NULL;
+
+    if ((uri = cupsGetOption("printer-uri-supported", query->dest->num_options, query->dest->options)) != NULL && httpSeparateURI(HTTP_URI_CODING_ALL, uri, scheme, sizeof(scheme), userpass, sizeof(userpass), host, sizeof(host), &port, resource, sizeof(resource)) >= HTTP_URI_STATUS_OK)
+    {
+      for (i = 0; i < num_conns; i ++)
+      {
+        if (conns[i].port == port && !strcmp(conns[i].host, host))
+        {
+          http = conns[i].http;
+          break;
+        }
+      }
+    }
+    else
+    {
+      host[0] = '\0';
+    }
+
+    if (!http)
+    {
+      // Connect to this printer...
+      if ((http = cupsConnectDest(query->dest, CUPS_DEST_FLAGS_NONE, 30000, /*cancel*/NULL, resource, sizeof(resource), /*cb*/NULL, /*user_data*/NULL)) == NULL)
+      {
+        cupsCopyString(query->error, cupsGetErrorString(), sizeof(query->error));
+      }
+      else if (host[0] && num_conns < LPSTAT_MAX_CONNS)
+      {
+        cupsCopyString(conns[num_conns].host, host, sizeof(conns[num_conns].host));
+        conns[num_conns].port = port;
+        conns[num_conns].http = http;
+        num_conns ++;
+      }
+    }
+
+    // Send the request...
+    if (http)
+    {
+      query->response = cupsDoRequest(http, query->request, resource);
+      query->request  = NULL;
+
+      for (i = 0; i < num_conns; i ++)
+      {
+        if (conns[i].http == http)
+          break;
+      }
+
+      if (i >= num_conns)
+        httpClose(http);
+    }
+
+    // Let the main thread know it is done...
+    cupsMutexLock(&pool->mutex);
+    query->done = true;
+    cupsCondBroadcast(&pool->cond);
+    cupsMutexUnlock(&pool->mutex);
+  }
+
+  // Close the cached connections...
+  for (i = 0; i < num_conns; i ++)
+    httpClose(conns[i].http);
+
+  return (NULL);
+}
+
+
 //
 // 'show_accepting()' - Show acceptance status.
 //
@@ -849,10 +1090,13 @@ show_jobs(const char   *command,	// I - Command name
 	  const char   *which_jobs)	// I - Show which jobs?
 {
   int		ret = 0;		// Return value
-  size_t	i;			// Looping var
+  size_t	i, j;			// Looping vars
   cups_dest_t	*dest;			// Current destination
-  http_t	*http;			// HTTP connection
-  char		resource[1024];		// Resource path
+  size_t	q,			// Current query
+		num_queries;		// Number of queries
+  lpstat_query_t *queries,		// Get-Jobs queries
+		*query;			// Current query
+  lpstat_queries_t pool;		// Query pool
   ipp_t		*request,		// IPP Request
 		*response;		// IPP Response
   ipp_attribute_t *attr;		// Current attribute
@@ -882,22 +1126,19 @@ show_jobs(const char   *command,	// I - Command name
   };
 
 
-  // Loop through the available destinations and report on those that match...
-  for (i = num_dests, dest = dests; i > 0; i --, dest ++)
+  // Send Get-Jobs requests to the destinations that match...
+  if ((queries = calloc(num_dests + 1, sizeof(lpstat_query_t))) == NULL)
+  {
+    cupsLangPrintf(stderr, _("%s: Unable to allocate memory."), command);
+    return (1);
+  }
+
+  for (i = num_dests, dest = dests, num_queries = 0; i > 0; i --, dest ++)
   {
     // Filter out printers we don't care about...
     if (dest->instance || (cupsArrayGetCount(printers) > 0 && !cupsArrayFind(printers, dest->name)))
       continue;
 
-    // Connect to this printer...
-    if ((http = cupsConnectDest(dest, CUPS_DEST_FLAGS_NONE, 30000, /*cancel*/NULL, resource, sizeof(resource), /*cb*/NULL, /*user_data*/NULL)) == NULL)
-    {
-      cupsLangPrintf(stderr, _("%s: Unable to connect to '%s': %s"), command, dest->name, cupsGetErrorString());
-      ret = 1;
-      continue;
-    }
-
-    // Get jobs list...
     request = ippNewRequest(IPP_OP_GET_JOBS);
 
     ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, cupsGetOption("printer-uri-supported", dest->num_options, dest->options));
@@ -905,7 +1146,25 @@ show_jobs(const char   *command,	// I - Command name
     ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsGetUser());
     ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "which-jobs", NULL, which_jobs);
 
-    response = cupsDoRequest(http, request, resource);
+    queries[num_queries].dest      = dest;
+    queries[num_queries ++].request = request;
+  }
+
+  query_start(&pool, num_queries, queries);
+
+  // Report on the destinations in order...
+  for (q = 0; q < num_queries; q ++)
+  {
+    query    = query_wait(&pool, q);
+    dest     = query->dest;
+    response = query->response;
+
+    if (query->error[0])
+    {
+      cupsLangPrintf(stderr, _("%s: Unable to connect to '%s': %s"), command, dest->name, query->error);
+      ret = 1;
+      continue;
+    }
 
     // Loop through the job list and display them...
     if (!strcmp(which_jobs, "completed"))
@@ -985,12 +1244,12 @@ show_jobs(const char   *command,	// I - Command name
 	  char		alerts[1024],	// Alerts string
 			*aptr;		// Pointer into alerts string
 
-	  for (i = 0, aptr = alerts; i < count; i ++)
+	  for (j = 0, aptr = alerts; j < count; j ++)
 	  {
-	    if (i)
-	      snprintf(aptr, sizeof(alerts) - (size_t)(aptr - alerts), " %s", ippGetString(state_reasons, i, NULL));
+	    if (j)
+	      snprintf(aptr, sizeof(alerts) - (size_t)(aptr - alerts), " %s", ippGetString(state_reasons, j, NULL));
 	    else
-	      cupsCopyString(alerts, ippGetString(state_reasons, i, NULL), sizeof(alerts));
+	      cupsCopyString(alerts, ippGetString(state_reasons, j, NULL), sizeof(alerts));
 
 	    aptr += strlen(aptr);
 	  }
@@ -1001,10 +1260,11 @@ show_jobs(const char   *command,	// I - Command name
 	cupsLangPrintf(stdout, _("\tqueued for %s"), dest->name);
       }
     }
-
-    ippDelete(response);
   }
 
+  query_finish(&pool);
+  free(queries);
+
   return (ret);
 }
 
@@ -1023,10 +1283,52 @@ show_printers(const char   *command,	// I - Command name
   int		ret = 0;		// Return value
   size_t	i, j;			// Looping vars
   cups_dest_t	*dest;			// Current destination
+  size_t	q,			// Current query
+		num_queries;		// Number of queries
+  lpstat_query_t *queries,		// Current job queries
+		*query;			// Current query
+  lpstat_queries_t pool;		// Query pool
+  ipp_t		*request;		// IPP Request
+  static const char * const jattrs[] =	// Attributes we need for jobs...
+  {
+    "job-id",
+    "job-state"
+  };
 
 
-  // Loop through the available destinations and report on those that match...
-  for (i = num_dests, dest = dests; i > 0; i --, dest ++)
+  // Find the destinations that match, getting the current job for the printers
+  // that are processing...
+  if ((queries = calloc(num_dests + 1, sizeof(lpstat_query_t))) == NULL)
+  {
+    cupsLangPrintf(stderr, _("%s: Unable to allocate memory."), command);
+    return (1);
+  }
+
+  for (i = num_dests, dest = dests, num_queries = 0; i > 0; i --, dest ++)
+  {
+    // Filter out printers we don't care about...
+    if (dest->instance || (cupsArrayGetCount(printers) > 0 && !cupsArrayFind(printers, dest->name)))
+      continue;
+
+    queries[num_queries].dest = dest;
+
+    if (cupsGetIntegerOption("printer-state", dest->num_options, dest->options) == IPP_PSTATE_PROCESSING)
+    {
+      request = ippNewRequest(IPP_OP_GET_JOBS);
+      ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, cupsGetOption("printer-uri-supported", dest->num_options, dest->options));
+      ippAddStrings(request, IPP_TAG_OPERATION, IPP_CONST_TAG(IPP_TAG_KEYWORD), "requested-attributes", sizeof(jattrs) / sizeof(jattrs[0]), NULL, jattrs);
+      ippAddInteger(request, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "limit", 1);
+
+      queries[num_queries].request = request;
+    }
+
+    num_queries ++;
+  }
+
+  query_start(&pool, num_queries, queries);
+
+  // Report on the destinations in order...
+  for (q = 0; q < num_queries; q ++)
   {
     int		job_id = 0;		// Current "job-id" value
     const char	*info,			// "printer-info" value
@@ -1038,9 +1340,8 @@ show_printers(const char   *command,	// I - Command name
     const char	*state_message;		// "printer-state-message" value
     cups_array_t *state_reasons;	// "printer-state-reasons" value
 
-    // Filter out printers we don't care about...
-    if (dest->instance || (cupsArrayGetCount(printers) > 0 && !cupsArrayFind(printers, dest->name)))
-      continue;
+    query = query_wait(&pool, q);
+    dest  = query->dest;
 
     // Grab values and report them...
     info              = cupsGetOption("printer-info", dest->num_options, dest->options);
@@ -1050,45 +1351,23 @@ show_printers(const char   *command,	// I - Command name
     if ((state_change_time = (time_t)cupsGetIntegerOption("printer-state-change-date-time", dest->num_options, dest->options)) == (time_t)LONG_MIN)
       state_change_time = (time_t)cupsGetIntegerOption("printer-state-change-time", dest->num_options, dest->options);
     state_message = cupsGetOption("printer-state-message", dest->num_options, dest->options);
-    state_reasons = cupsArrayNewStrings(cupsGetOption("printer-state-reasons", dest->num_options, dest->options), ',');
 
     strdate(state_change_date, sizeof(state_change_date), state_change_time);
 
-    // If the printer state is `IPP_PSTATE_PROCESSING`, then grab the current job for the printer.
-    if (state == IPP_PSTATE_PROCESSING)
+    // If the printer state is `IPP_PSTATE_PROCESSING`, then use the current job for the printer.
+    if (query->error[0])
     {
-      http_t	*http;			// Connection to printer
-      char	resource[1024];		// Resource path
-      ipp_t	*request,		// IPP Request
-		*response;		// IPP Response
-      static const char * const jattrs[] =
-      {					// Attributes we need for jobs...
-	"job-id",
-	"job-state"
-      };
-
-      // Connect to this printer...
-      if ((http = cupsConnectDest(dest, CUPS_DEST_FLAGS_NONE, 30000, /*cancel*/NULL, resource, sizeof(resource), /*cb*/NULL, /*user_data*/NULL)) == NULL)
-      {
-	cupsLangPrintf(stderr, _("%s: Unable to connect to '%s': %s"), command, dest->name, cupsGetErrorString());
-	ret = 1;
-	continue;
-      }
-
-      request = ippNewRequest(IPP_OP_GET_JOBS);
-      ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, cupsGetOption("printer-uri-supported", dest->num_options, dest->options));
-      ippAddStrings(request, IPP_TAG_OPERATION, IPP_CONST_TAG(IPP_TAG_KEYWORD), "requested-attributes", sizeof(jattrs) / sizeof(jattrs[0]), NULL, jattrs);
-      ippAddInteger(request, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "limit", 1);
-
-      response = cupsDoRequest(http, request, resource);
-
-      if (ippGetInteger(ippFindAttribute(response, "job-state", IPP_TAG_ENUM), 0) == IPP_JSTATE_PROCESSING)
-        job_id = ippGetInteger(ippFindAttribute(response, "job-id", IPP_TAG_INTEGER), 0);
-
-      ippDelete(response);
-      httpClose(http);
+      cupsLangPrintf(stderr, _("%s: Unable to connect to '%s': %s"), command, dest->name, query->error);
+      ret = 1;
+      continue;
+    }
+    else if (ippGetInteger(ippFindAttribute(query->response, "job-state", IPP_TAG_ENUM), 0) == IPP_JSTATE_PROCESSING)
+    {
+      job_id = ippGetInteger(ippFindAttribute(query->response, "job-id", IPP_TAG_INTEGER), 0);
     }
 
+    state_reasons = cupsArrayNewStrings(cupsGetOption("printer-state-reasons", dest->num_options, dest->options), ',');
+
     // Display it...
     switch (state)
     {
@@ -1144,6 +1423,9 @@ show_printers(const char   *command,	// I - Command name
     cupsArrayDelete(state_reasons);
   }
 
+  query_finish(&pool);
+  free(queries);
+
   return (ret);
 }
 
@@ -0,0 +1,743 @@
+//
+// End-to-end job benchmark for cupslocald.
+//
+// Usage:
+//
+//   ./benchjobs [OPTIONS] FILENAME [... FILENAME]
+//
+// A private cupslocald is started with a temporary socket, spool directory,
+// and state file, and one stand-in printer is added for each concurrent job.
+// Each stand-in printer uses a "socket://" device URI that points at a port
+// served by this program, which records when the first byte of each job
+// arrives.  The files are printed in turn using "lp" until the requested
+// number of jobs has been printed, then the throughput, latency to the first
+// byte at the device, and cupslocald CPU time per page are reported.
+//
+// The CPU time is collected when cupslocald exits and includes the processes
+// it has waited for.  Transform workers that are still running at exit are
+// not counted, so transform commands are run directly ("-w 0") by default.
+//
+// Copyright © 2025 by OpenPrinting.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+#include "cupslocald.h"
+#include <cups/thread.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+extern char **environ;
+
+
+//
+// Local types...
+//
+
+typedef struct bench_job_s		// Job results
+{
+  bool		ok;			// Did the job complete?
+  double	first_byte,		// Time to the first byte at the device
+		elapsed;		// Time to job completion
+  int		pages;			// Number of pages
+  size_t	bytes;			// Bytes received by the device
+} bench_job_t;
+
+typedef struct bench_printer_s		// Stand-in printer
+{
+  char		name[64],		// Printer name
+		resource[256];		// Printer resource path
+  int		fd;			// Listening socket
+  int		port;			// Port number
+  cups_mutex_t	mutex;			// Mutex for device data
+  double	first_byte;		// Time of first byte or 0.0
+  size_t	bytes;			// Bytes received
+  cups_thread_t	device_thread,		// Device thread
+		job_thread;		// Job thread
+} bench_printer_t;
+
+
+//
+// Local globals...
+//
+
+static const char	*bench_commands = "../commands";
+					// Directory containing "lp"
+static const char	**bench_files = NULL;
+					// Files to print
+static int		bench_num_files = 0;
+					// Number of files to print
+static bench_job_t	*bench_jobs = NULL;
+					// Job results
+static int		bench_num_jobs = 0;
+					// Number of jobs to print
+static int		bench_next_job = 0;
+					// Next job to print
+static cups_mutex_t	bench_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for next job
+static char		bench_socket[1024];
+					// cupslocald domain socket
+static bool		bench_stop = false;
+					// Stop the device threads?
+static double		bench_timeout = 300.0;
+					// Timeout for each job in seconds
+
+
+//
+// Local functions...
+//
+
+static int	compare_doubles(const double *a, const double *b);
+static void	*device_thread(bench_printer_t *printer);
+static void	*job_thread(bench_printer_t *printer);
+static double	percentile(double *values, size_t num_values, double p);
+static int	print_file(bench_printer_t *printer, const char *filename);
+static int	run_command(const char *command, const char * const *args, char *output, size_t outsize);
+static bool	start_printer(bench_printer_t *printer, int num, const char *driver);
+static int	usage(FILE *fp);
+static bool	wait_job(http_t *http, bench_printer_t *printer, int job_id, int *pages);
+
+
+//
+// 'main()' - Main entry.
+//
+
+int					// O - Exit status
+main(int  argc,				// I - Number of command-line arguments
+     char *argv[])			// I - Command-line arguments
+{
+  int			i;		// Looping var
+  const char		*opt;		// Current option
+  int			concurrency = 1;// Number of concurrent jobs
+  const char		*daemon = "./cupslocald",
+					// cupslocald program
+			*driver = "pcl",// Printer driver
+			*workers = "0";	// Number of transform workers
+  char			tempdir[256],	// Temporary directory
+			spooldir[1024],	// Spool directory
+			statefile[1024],// State file
+			logfile[1024];	// Log file
+  pid_t			pid;		// cupslocald process ID
+  int			status;		// Exit status of cupslocald
+  struct rusage		usage_info;	// cupslocald resource usage
+  bench_printer_t	*printers;	// Stand-in printers
+  http_t		*http = NULL;	// Connection to cupslocald
+  double		start,		// Start time
+			elapsed,	// Elapsed time
+			cpu,		// CPU time
+			*first_bytes,	// Times to first byte
+			*elapseds;	// Times to completion
+  size_t		num_ok = 0;	// Number of completed jobs
+  int			pages = 0;	// Number of pages
+  size_t		bytes = 0;	// Number of device bytes
+
+
+  if ((bench_files = calloc((size_t)argc, sizeof(char *))) == NULL)
+  {
+    perror("benchjobs");
+    return (1);
+  }
+
+  for (i = 1; i < argc; i ++)
+  {
+    if (!strcmp(argv[i], "--help"))
+    {
+      return (usage(stdout));
+    }
+    else if (argv[i][0] == '-')
+    {
+      for (opt = argv[i] + 1; *opt; opt ++)
+      {
+        switch (*opt)
+        {
+          case 'C' : // -C DIRECTORY
+              i ++;
+              if (i >= argc)
+              {
+                fputs("benchjobs: Expected directory after '-C'.\n", stderr);
+                return (usage(stderr));
+              }
+              bench_commands = argv[i];
+              break;
+
+          case 'c' : // -c CONCURRENCY
+              i ++;
+              if (i >= argc || (concurrency = atoi(argv[i])) < 1 || concurrency > 64)
+              {
+                fputs("benchjobs: Expected concurrency from 1 to 64 after '-c'.\n", stderr);
+                return (usage(stderr));
+              }
+              break;
+
+          case 'D' : // -D PROGRAM
+              i ++;
+              if (i >= argc)
+              {
+                fputs("benchjobs: Expected program after '-D'.\n", stderr);
+                return (usage(stderr));
+              }
+              daemon = argv[i];
+              break;
+
+          case 'm' : // -m DRIVER
+              i ++;
+              if (i >= argc)
+              {
+                fputs("benchjobs: Expected driver after '-m'.\n", stderr);
+                return (usage(stderr));
+              }
+              driver = argv[i];
+              break;
+
+          case 'n' : // -n JOBS
+              i ++;
+              if (i >= argc || (bench_num_jobs = atoi(argv[i])) < 1)
+              {
+                fputs("benchjobs: Expected number of jobs after '-n'.\n", stderr);
+                return (usage(stderr));
+              }
+              break;
+
+          case 't' : // -t SECONDS
+              i ++;
+              if (i >= argc || (bench_timeout = atof(argv[i])) <= 0.0)
+              {
+                fputs("benchjobs: Expected timeout after '-t'.\n", stderr);
+                return (usage(stderr));
+              }
+              break;
+
+          case 'w' : // -w WORKERS
+              i ++;
+              if (i >= argc || !isdigit(argv[i][0] & 255))
+              {
+                fputs("benchjobs: Expected number of workers after '-w'.\n", stderr);
+                return (usage(stderr));
+              }
+              workers = argv[i];
+              break;
+
+          default :
+              fprintf(stderr, "benchjobs: Unknown option '-%c'.\n", *opt);
+              return (usage(stderr));
+        }
+      }
+    }
+    else
+    {
+      bench_files[bench_num_files ++] = argv[i];
+    }
+  }
+
+  if (bench_num_files == 0)
+  {
+    fputs("benchjobs: No files to print.\n", stderr);
+    return (usage(stderr));
+  }
+
+  if (bench_num_jobs == 0)
+    bench_num_jobs = bench_num_files;
+
+  if ((bench_jobs = calloc((size_t)bench_num_jobs, sizeof(bench_job_t))) == NULL || (printers = calloc((size_t)concurrency, sizeof(bench_printer_t))) == NULL)
+  {
+    perror("benchjobs");
+    return (1);
+  }
+
+  // Start cupslocald with its own socket, spool directory, and state file...
+  snprintf(tempdir, sizeof(tempdir), "%s/benchjobsXXXXXX", getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp");
+  if (!mkdtemp(tempdir))
+  {
+    fprintf(stderr, "benchjobs: %s: %s\n", tempdir, strerror(errno));
+    return (1);
+  }
+
+  snprintf(bench_socket, sizeof(bench_socket), "%s/sock", tempdir);
+  snprintf(spooldir, sizeof(spooldir), "%s/spool", tempdir);
+  snprintf(statefile, sizeof(statefile), "%s/state", tempdir);
+  snprintf(logfile, sizeof(logfile), "%s/log", tempdir);
+
+  // The commands and this program talk to the private cupslocald...
+  setenv("CUPS_SERVER", bench_socket, 1);
+  setenv("LC_ALL", "C", 1);
+
+  {
+    const char	*args[] =		// cupslocald arguments
+    {
+      daemon, "-d", spooldir, "-S", bench_socket, "-s", statefile, "-l", logfile, "-L", "info", "-w", workers, NULL
+    };
+
+    if (posix_spawn(&pid, daemon, NULL, NULL, (char * const *)args, environ))
+    {
+      fprintf(stderr, "benchjobs: Unable to start '%s': %s\n", daemon, strerror(errno));
+      return (1);
+    }
+  }
+
+  for (start = cupsGetClock(); (cupsGetClock() - start) < 30.0; usleep(100000))
+  {
+    if ((http = httpConnect(bench_socket, 0, /*addrlist*/NULL, AF_UNSPEC, HTTP_ENCRYPTION_IF_REQUESTED, /*blocking*/true, 1000, /*cancel*/NULL)) != NULL)
+      break;
+  }
+
+  if (!http)
+  {
+    fprintf(stderr, "benchjobs: cupslocald did not start, see '%s'.\n", logfile);
+    kill(pid, SIGTERM);
+    return (1);
+  }
+
+  httpClose(http);
+
+  // Add the stand-in printers...
+  for (i = 0; i < concurrency; i ++)
+  {
+    if (!start_printer(printers + i, i + 1, driver))
+    {
+      kill(pid, SIGTERM);
+      return (1);
+    }
+  }
+
+  // Print the jobs...
+  printf("Printing %d job(s) on %d printer(s) using the '%s' driver...\n", bench_num_jobs, concurrency, driver);
+
+  start = cupsGetClock();
+
+  for (i = 0; i < concurrency; i ++)
+    printers[i].job_thread = cupsThreadCreate((cups_thread_func_t)job_thread, printers + i);
+
+  for (i = 0; i < concurrency; i ++)
+    cupsThreadWait(printers[i].job_thread);
+
+  elapsed = cupsGetClock() - start;
+
+  // Stop cupslocald and get its CPU usage...
+  kill(pid, SIGTERM);
+  while (wait4(pid, &status, 0, &usage_info) < 0 && errno == EINTR);
+
+  cpu = usage_info.ru_utime.tv_sec + 0.000001 * usage_info.ru_utime.tv_usec + usage_info.ru_stime.tv_sec + 0.000001 * usage_info.ru_stime.tv_usec;
+
+  bench_stop = true;
+
+  for (i = 0; i < concurrency; i ++)
+    cupsThreadWait(printers[i].device_thread);
+
+  // Report the results...
+  first_bytes = calloc((size_t)bench_num_jobs, sizeof(double));
+  elapseds    = calloc((size_t)bench_num_jobs, sizeof(double));
+
+  if (!first_bytes || !elapseds)
+  {
+    perror("benchjobs");
+    return (1);
+  }
+
+  for (i = 0; i < bench_num_jobs; i ++)
+  {
+    if (!bench_jobs[i].ok)
+      continue;
+
+    first_bytes[num_ok] = bench_jobs[i].first_byte;
+    elapseds[num_ok]    = bench_jobs[i].elapsed;
+    pages               += bench_jobs[i].pages;
+    bytes               += bench_jobs[i].bytes;
+    num_ok ++;
+  }
+
+  printf("Jobs:        %d completed, %d failed in %.3f seconds (%.2f jobs/s)\n", (int)num_ok, bench_num_jobs - (int)num_ok, elapsed, num_ok / elapsed);
+
+  if (num_ok > 0)
+  {
+    printf("First byte:  p50 %.1fms, p99 %.1fms\n", 1000.0 * percentile(first_bytes, num_ok, 0.5), 1000.0 * percentile(first_bytes, num_ok, 0.99));
+    printf("Completion:  p50 %.1fms, p99 %.1fms\n", 1000.0 * percentile(elapseds, num_ok, 0.5), 1000.0 * percentile(elapseds, num_ok, 0.99));
+    printf("Output:      %d page(s), %lu bytes\n", pages, (unsigned long)bytes);
+  }
+
+  printf("CPU:         %.3f seconds", cpu);
+  if (pages > 0)
+    printf(" (%.1fms per page)", 1000.0 * cpu / pages);
+  putchar('\n');
+
+  printf("Log file:    %s\n", logfile);
+
+  return (num_ok == (size_t)bench_num_jobs ? 0 : 1);
+}
+
+
+//
+// 'compare_doubles()' - Compare two times.
+//
+
+static int				// O - Result of comparison
+compare_doubles(const double *a,	// I - First time
+                const double *b)	// I - Second time
+{
+  if (*a < *b)
+    return (-1);
+  else if (*a > *b)
+    return (1);
+  else
+    return (0);
+}
+
+
+//
+// 'device_thread()' - Receive print data for a stand-in printer.
+//
+
+static void *				// O - Thread exit status
+device_thread(bench_printer_t *printer)	// I - Printer
+{
+  int		fd;			// Client connection
+  struct pollfd	pfd;			// Listening socket
+  ssize_t	bytes;			// Bytes read
+  char		buffer[65536];		// Read buffer
+
+
+  pfd.fd     = printer->fd;
+  pfd.events = POLLIN;
+
+  while (!bench_stop)
+  {
+    if (poll(&pfd, 1, 1000) <= 0 || (fd = accept(printer->fd, NULL, NULL)) < 0)
+      continue;
+
+    // Read until the job closes the connection...
+    while ((bytes = read(fd, buffer, sizeof(buffer))) != 0)
+    {
+      if (bytes < 0)
+      {
+        if (errno == EINTR || errno == EAGAIN)
+          continue;
+        break;
+      }
+
+      cupsMutexLock(&printer->mutex);
+      if (printer->first_byte == 0.0)
+        printer->first_byte = cupsGetClock();
+      printer->bytes += (size_t)bytes;
+      cupsMutexUnlock(&printer->mutex);
+    }
+
+    close(fd);
+  }
+
+  close(printer->fd);
+
+  return (NULL);
+}
+
+
+//
+// 'job_thread()' - Print jobs on a stand-in printer until there are none left.
+//
+
+static void *				// O - Thread exit status
+job_thread(bench_printer_t *printer)	// I - Printer
+{
+  int		job;			// Current job
+  int		job_id;			// Job ID from "lp"
+  bench_job_t	*result;		// Job result
+  double	start;			// Start time
+  http_t	*http;			// Connection to cupslocald
+
+
+  if ((http = httpConnect(bench_socket, 0, /*addrlist*/NULL, AF_UNSPEC, HTTP_ENCRYPTION_IF_REQUESTED, /*blocking*/true, 30000, /*cancel*/NULL)) == NULL)
+  {
+    fprintf(stderr, "benchjobs: Unable to connect to cupslocald: %s\n", cupsGetErrorString());
+    return (NULL);
+  }
+
+  for (;;)
+  {
+    cupsMutexLock(&bench_mutex);
+    job = bench_next_job ++;
+    cupsMutexUnlock(&bench_mutex);
+
+    if (job >= bench_num_jobs)
+      break;
+
+    result = bench_jobs + job;
+
+    cupsMutexLock(&printer->mutex);
+    printer->first_byte = 0.0;
+    printer->bytes      = 0;
+    cupsMutexUnlock(&printer->mutex);
+
+    start = cupsGetClock();
+
+    if ((job_id = print_file(printer, bench_files[job % bench_num_files])) <= 0)
+      continue;
+
+    if (!wait_job(http, printer, job_id, &result->pages))
+      continue;
+
+    result->elapsed = cupsGetClock() - start;
+
+    cupsMutexLock(&printer->mutex);
+    result->ok         = printer->first_byte > 0.0;
+    result->first_byte = printer->first_byte - start;
+    result->bytes      = printer->bytes;
+    cupsMutexUnlock(&printer->mutex);
+
+    if (!result->ok)
+      fprintf(stderr, "benchjobs: %s-%d: No output for '%s'.\n", printer->name, job_id, bench_files[job % bench_num_files]);
+  }
+
+  httpClose(http);
+
+  return (NULL);
+}
+
+
+//
+// 'percentile()' - Get a percentile from a list of values.
+//
+
+static double				// O - Value at percentile
+percentile(double *values,		// I - Values (sorted on return)
+           size_t num_values,		// I - Number of values
+           double p)			// I - Percentile (0.0 to 1.0)
+{
+  qsort(values, num_values, sizeof(double), (int (*)(const void *, const void *))compare_doubles);
+
+  return (values[(size_t)(p * (num_values - 1) + 0.5)]);
+}
+
+
+//
+// 'print_file()' - Print a file using "lp".
+//
+
+static int				// O - Job ID or 0 on error
+print_file(bench_printer_t *printer,	// I - Printer
+           const char      *filename)	// I - File to print
+{
+  char		command[1024],		// "lp" command
+		output[1024],		// Output from "lp"
+		*ptr;			// Pointer into output
+  const char	*args[] =		// Arguments for "lp"
+  {
+    "lp", "-d", printer->name, filename, NULL
+  };
+
+
+  snprintf(command, sizeof(command), "%s/lp", bench_commands);
+
+  if (run_command(command, args, output, sizeof(output)))
+  {
+    fprintf(stderr, "benchjobs: Unable to print '%s' on '%s'.\n", filename, printer->name);
+    return (0);
+  }
+
+  // Output is "request id is PRINTER-JOBID (N file(s))"...
+  if ((ptr = strstr(output, printer->name)) == NULL || ptr[strlen(printer->name)] != '-')
+  {
+    fprintf(stderr, "benchjobs: Unexpected output from lp: %s\n", output);
+    return (0);
+  }
+
+  return (atoi(ptr + strlen(printer->name) + 1));
+}
+
+
+//
+// 'run_command()' - Run a command and collect its output.
+//
+
+static int				// O - Exit status
+run_command(const char        *command,	// I - Command to run
+            const char * const *args,	// I - Arguments
+            char              *output,	// I - Output buffer
+            size_t            outsize)	// I - Size of output buffer
+{
+  int				fds[2];	// Output pipe
+  pid_t				pid;	// Process ID
+  int				status;	// Exit status
+  ssize_t			bytes;	// Bytes read
+  size_t			outlen = 0;
+					// Length of output
+  posix_spawn_file_actions_t	actions;// File actions
+
+
+  *output = '\0';
+
+  if (pipe(fds))
+    return (-1);
+
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, fds[1], 1);
+  posix_spawn_file_actions_addclose(&actions, fds[0]);
+
+  status = posix_spawn(&pid, command, &actions, NULL, (char * const *)args, environ);
+
+  posix_spawn_file_actions_destroy(&actions);
+  close(fds[1]);
+
+  if (status)
+  {
+    fprintf(stderr, "benchjobs: Unable to run '%s': %s\n", command, strerror(status));
+    close(fds[0]);
+    return (-1);
+  }
+
+  while ((bytes = read(fds[0], output + outlen, outsize - outlen - 1)) != 0)
+  {
+    if (bytes < 0)
+    {
+      if (errno == EINTR || errno == EAGAIN)
+        continue;
+      break;
+    }
+
+    if ((outlen += (size_t)bytes) >= (outsize - 1))
+      break;
+  }
+
+  output[outlen] = '\0';
+  close(fds[0]);
+
+  while (waitpid(pid, &status, 0) < 0 && errno == EINTR);
+
+  return (status);
+}
+
+
+//
+// 'start_printer()' - Start a stand-in printer and add it to cupslocald.
+//
+
+static bool				// O - `true` on success, `false` on failure
+start_printer(bench_printer_t *printer,	// I - Printer
+              int             num,	// I - Printer number
+              const char      *driver)	// I - Printer driver
+{
+  struct sockaddr_in	addr;		// Listening address
+  socklen_t		addrlen = sizeof(addr);
+					// Length of address
+  char			command[1024],	// "lpadmin" command
+			device_uri[256],// Device URI
+			output[1024];	// Output from "lpadmin"
+  const char		*args[] =	// Arguments for "lpadmin"
+  {
+    "lpadmin", "-p", printer->name, "-v", device_uri, "-m", driver, NULL
+  };
+
+
+  snprintf(printer->name, sizeof(printer->name), "bench-%d", num);
+  snprintf(printer->resource, sizeof(printer->resource), "/ipp/print/%s", printer->name);
+  cupsMutexInit(&printer->mutex);
+
+  // Listen for print data on a local port...
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family      = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  if ((printer->fd = socket(AF_INET, SOCK_STREAM, 0)) < 0 || bind(printer->fd, (struct sockaddr *)&addr, sizeof(addr)) || listen(printer->fd, 4) || getsockname(printer->fd, (struct sockaddr *)&addr, &addrlen))
+  {
+    fprintf(stderr, "benchjobs: Unable to listen for '%s': %s\n", printer->name, strerror(errno));
+    return (false);
+  }
+
+  printer->port          = ntohs(addr.sin_port);
+  printer->device_thread = cupsThreadCreate((cups_thread_func_t)device_thread, printer);
+
+  // Then add the printer...
+  snprintf(command, sizeof(command), "%s/lpadmin", bench_commands);
+  snprintf(device_uri, sizeof(device_uri), "socket://127.0.0.1:%d", printer->port);
+
+  if (run_command(command, args, output, sizeof(output)))
+  {
+    fprintf(stderr, "benchjobs: Unable to add printer '%s'.\n", printer->name);
+    return (false);
+  }
+
+  return (true);
+}
+
+
+//
+// 'usage()' - Show program usage.
+//
+
+static int				// O - Exit status
+usage(FILE *fp)				// I - Output file
+{
+  fputs("Usage: benchjobs [OPTIONS] FILENAME [... FILENAME]\n", fp);
+  fputs("Options:\n", fp);
+  fputs("--help                         Show this help\n", fp);
+  fputs("-C DIRECTORY                   Set the directory for lp and lpadmin (default ../commands)\n", fp);
+  fputs("-c CONCURRENCY                 Set the number of concurrent jobs (default 1)\n", fp);
+  fputs("-D PROGRAM                     Set the cupslocald program (default ./cupslocald)\n", fp);
+  fputs("-m DRIVER                      Set the printer driver (default pcl)\n", fp);
+  fputs("-n JOBS                        Set the number of jobs (default one per file)\n", fp);
+  fputs("-t SECONDS                     Set the timeout for each job (default 300)\n", fp);
+  fputs("-w WORKERS                     Set the number of transform workers (default 0)\n", fp);
+
+  return (fp == stdout ? 0 : 1);
+}
+
+
+//
+// 'wait_job()' - Wait for a job to finish.
+//
+
+static bool				// O - `true` if completed, `false` otherwise
+wait_job(http_t          *http,		// I - Connection to cupslocald
+         bench_printer_t *printer,	// I - Printer
+         int             job_id,	// I - Job ID
+         int             *pages)	// O - Number of pages
+{
+  ipp_t		*request,		// IPP request
+		*response;		// IPP response
+  ipp_jstate_t	state = IPP_JSTATE_PENDING;
+					// Job state
+  double	end = cupsGetClock() + bench_timeout;
+					// End time
+  char		uri[1024];		// Printer URI
+  static const char * const requested[] =
+  {					// Requested attributes
+    "job-impressions-completed",
+    "job-state"
+  };
+
+
+  *pages = 0;
+
+  httpAssembleURI(HTTP_URI_CODING_ALL, uri, sizeof(uri), "ipp", /*userpass*/NULL, "localhost", 0, printer->resource);
+
+  while (state < IPP_JSTATE_CANCELED && cupsGetClock() < end)
+  {
+    usleep(20000);
+
+    request = ippNewRequest(IPP_OP_GET_JOB_ATTRIBUTES);
+    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, uri);
+    ippAddInteger(request, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "job-id", job_id);
+    ippAddStrings(request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "requested-attributes", sizeof(requested) / sizeof(requested[0]), NULL, requested);
+
+    if ((response = cupsDoRequest(http, request, printer->resource)) == NULL)
+      break;
+
+    state  = (ipp_jstate_t)ippGetInteger(ippFindAttribute(response, "job-state", IPP_TAG_ENUM), 0);
+    *pages = ippGetInteger(ippFindAttribute(response, "job-impressions-completed", IPP_TAG_INTEGER), 0);
+
+    ippDelete(response);
+
+    if (state == 0)
+      break;
+  }
+
+  if (state != IPP_JSTATE_COMPLETED)
+  {
+    fprintf(stderr, "benchjobs: %s-%d did not complete.\n", printer->name, job_id);
+    return (false);
+  }
+
+  return (true);
+}
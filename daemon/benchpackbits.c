@@ -0,0 +1,343 @@
+//
+// PackBits compression benchmark for cupslocald.
+//
+// Usage:
+//
+//   ./benchpackbits [-n ITERATIONS] [-w BYTES] [FILENAME ...]
+//
+// With no files, synthetic raster lines are compressed.  Otherwise each file
+// is read as raw 1-bit or 8-bit raster data that is split into lines of
+// BYTES bytes (default 600, a 4800 pixel 1-bit line).
+//
+// Copyright © 2025 by OpenPrinting.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+#include "cupslocald.h"
+
+
+//
+// Local functions...
+//
+
+static bool	bench_lines(const char *name, const unsigned char *data, size_t datalen, size_t linelen, int iterations);
+static size_t	packbits_ref(unsigned char *dst, const unsigned char *src, size_t length);
+static int	usage(FILE *fp);
+
+
+//
+// 'main()' - Main entry.
+//
+
+int					// O - Exit status
+main(int  argc,				// I - Number of command-line arguments
+     char *argv[])			// I - Command-line arguments
+{
+  int		i;			// Looping var
+  const char	*opt;			// Current option
+  int		iterations = 100;	// Number of iterations
+  size_t	linelen = 600;		// Line length
+  bool		files = false;		// Files on command-line?
+  int		status = 0;		// Exit status
+
+
+  for (i = 1; i < argc; i ++)
+  {
+    if (!strcmp(argv[i], "--help"))
+    {
+      return (usage(stdout));
+    }
+    else if (argv[i][0] == '-')
+    {
+      for (opt = argv[i] + 1; *opt; opt ++)
+      {
+        switch (*opt)
+        {
+          case 'n' : // -n ITERATIONS
+              i ++;
+              if (i >= argc || (iterations = atoi(argv[i])) < 1)
+              {
+                fputs("benchpackbits: Expected number of iterations after '-n'.\n", stderr);
+                return (usage(stderr));
+              }
+              break;
+
+          case 'w' : // -w BYTES
+              i ++;
+              if (i >= argc || atoi(argv[i]) < 1)
+              {
+                fputs("benchpackbits: Expected line length after '-w'.\n", stderr);
+                return (usage(stderr));
+              }
+              linelen = (size_t)atoi(argv[i]);
+              break;
+
+          default :
+              fprintf(stderr, "benchpackbits: Unknown option '-%c'.\n", *opt);
+              return (usage(stderr));
+        }
+      }
+    }
+    else
+    {
+      // Benchmark a raster file...
+      int		fd;		// File descriptor
+      struct stat	fileinfo;	// File information
+      unsigned char	*data;		// File data
+      ssize_t		bytes;		// Bytes read
+
+      files = true;
+
+      if ((fd = open(argv[i], O_RDONLY)) < 0 || fstat(fd, &fileinfo))
+      {
+        fprintf(stderr, "benchpackbits: %s: %s\n", argv[i], strerror(errno));
+        if (fd >= 0)
+          close(fd);
+        status = 1;
+        continue;
+      }
+
+      if ((data = malloc((size_t)fileinfo.st_size + 1)) == NULL)
+      {
+        fprintf(stderr, "benchpackbits: %s: %s\n", argv[i], strerror(errno));
+        close(fd);
+        return (1);
+      }
+
+      if ((bytes = read(fd, data, (size_t)fileinfo.st_size)) != (ssize_t)fileinfo.st_size)
+      {
+        fprintf(stderr, "benchpackbits: %s: %s\n", argv[i], bytes < 0 ? strerror(errno) : "Short read.");
+        status = 1;
+      }
+      else if (!bench_lines(argv[i], data, (size_t)bytes, linelen, iterations))
+      {
+        status = 1;
+      }
+
+      free(data);
+      close(fd);
+    }
+  }
+
+  if (!files)
+  {
+    // Benchmark synthetic raster data...
+    size_t		j,		// Looping var
+			datalen = linelen * 1000;
+					// Length of data
+    unsigned char	*data;		// Raster data
+    unsigned		seed = 1;	// Random number seed
+
+    if ((data = malloc(datalen)) == NULL)
+    {
+      perror("benchpackbits");
+      return (1);
+    }
+
+    // Blank lines...
+    memset(data, 0, datalen);
+    if (!bench_lines("blank", data, datalen, linelen, iterations))
+      status = 1;
+
+    // Solid lines...
+    memset(data, 255, datalen);
+    if (!bench_lines("solid", data, datalen, linelen, iterations))
+      status = 1;
+
+    // Halftone - 50% checkerboard pattern...
+    for (j = 0; j < datalen; j ++)
+      data[j] = (j / linelen) & 1 ? 0xaa : 0x55;
+    if (!bench_lines("halftone", data, datalen, linelen, iterations))
+      status = 1;
+
+    // Text - short bursts of data on a blank background...
+    memset(data, 0, datalen);
+    for (j = 0; (j + 1) < datalen; j += 16 + (seed % 48))
+    {
+      seed = seed * 1103515245 + 12345;
+      data[j]     = (unsigned char)(seed >> 16);
+      data[j + 1] = (unsigned char)(seed >> 8);
+    }
+    if (!bench_lines("text", data, datalen, linelen, iterations))
+      status = 1;
+
+    // Photo - random data...
+    for (j = 0; j < datalen; j ++)
+    {
+      seed    = seed * 1103515245 + 12345;
+      data[j] = (unsigned char)(seed >> 16);
+    }
+    if (!bench_lines("random", data, datalen, linelen, iterations))
+      status = 1;
+
+    free(data);
+  }
+
+  return (status);
+}
+
+
+//
+// 'bench_lines()' - Compress lines of raster data and show the timing.
+//
+
+static bool				// O - `true` if output matches, `false` otherwise
+bench_lines(const char          *name,	// I - Name of data
+            const unsigned char *data,	// I - Raster data
+            size_t              datalen,// I - Length of raster data
+            size_t              linelen,// I - Length of each line
+            int                 iterations)
+					// I - Number of iterations
+{
+  int		i;			// Looping var
+  size_t	offset,			// Offset in data
+		length,			// Length of current line
+		complen,		// Compressed length
+		reflen;			// Reference compressed length
+  unsigned char	*buffer,		// Compression buffer
+		*refbuffer;		// Reference compression buffer
+  double	start,			// Start time
+		reftime,		// Reference time
+		newtime;		// LocalPackBits time
+  bool		ret = true;		// Return value
+
+
+  if ((buffer = malloc(2 * linelen + 2)) == NULL || (refbuffer = malloc(2 * linelen + 2)) == NULL)
+  {
+    perror("benchpackbits");
+    free(buffer);
+    return (false);
+  }
+
+  // Make sure the output is the same...
+  for (offset = 0; offset < datalen && ret; offset += linelen)
+  {
+    if ((length = datalen - offset) > linelen)
+      length = linelen;
+
+    reflen  = packbits_ref(refbuffer, data + offset, length);
+    complen = LocalPackBits(buffer, data + offset, length);
+
+    if (complen != reflen || memcmp(buffer, refbuffer, reflen))
+    {
+      fprintf(stderr, "benchpackbits: %s: Output differs at offset %lu.\n", name, (unsigned long)offset);
+      ret = false;
+    }
+  }
+
+  if (ret)
+  {
+    // Time the reference and new code...
+    start = cupsGetClock();
+    for (i = 0, reflen = 0; i < iterations; i ++)
+    {
+      for (offset = 0; offset < datalen; offset += linelen)
+        reflen += packbits_ref(refbuffer, data + offset, datalen - offset > linelen ? linelen : datalen - offset);
+    }
+    reftime = cupsGetClock() - start;
+
+    start = cupsGetClock();
+    for (i = 0, complen = 0; i < iterations; i ++)
+    {
+      for (offset = 0; offset < datalen; offset += linelen)
+        complen += LocalPackBits(buffer, data + offset, datalen - offset > linelen ? linelen : datalen - offset);
+    }
+    newtime = cupsGetClock() - start;
+
+    printf("%-16s %8lu bytes -> %8lu bytes, %8.1f MB/s (byte loop %8.1f MB/s)\n", name, (unsigned long)datalen, (unsigned long)(complen / (size_t)iterations), datalen * iterations / newtime / 1000000.0, datalen * iterations / reftime / 1000000.0);
+  }
+
+  free(buffer);
+  free(refbuffer);
+
+  return (ret);
+}
+
+
+//
+// 'packbits_ref()' - Compress a line one byte at a time.
+//
+// This is the original PCL driver code, used to check the output.
+//
+
+static size_t				// O - Length of compressed data
+packbits_ref(
+    unsigned char       *dst,		// I - Destination buffer
+    const unsigned char *src,		// I - Line to compress
+    size_t              length)		// I - Number of bytes
+{
+  const unsigned char	*line_ptr,	// Current byte pointer
+			*line_end,	// End-of-line byte pointer
+			*start;		// Start of compression sequence
+  unsigned char		*comp_ptr;	// Pointer into compression buffer
+  unsigned		count;		// Count of bytes for output
+
+
+  line_ptr = src;
+  line_end = src + length;
+  comp_ptr = dst;
+
+  while (line_ptr < line_end)
+  {
+    if ((line_ptr + 1) >= line_end)
+    {
+      // Single byte on the end...
+      *comp_ptr++ = 0x00;
+      *comp_ptr++ = *line_ptr++;
+    }
+    else if (line_ptr[0] == line_ptr[1])
+    {
+      // Repeated sequence...
+      line_ptr ++;
+      count = 2;
+
+      while (line_ptr < (line_end - 1) && line_ptr[0] == line_ptr[1] && count < 128)
+      {
+	line_ptr ++;
+	count ++;
+      }
+
+      *comp_ptr++ = (unsigned char)(257 - count);
+      *comp_ptr++ = *line_ptr++;
+    }
+    else
+    {
+      // Non-repeated sequence...
+      start    = line_ptr;
+      line_ptr ++;
+      count    = 1;
+
+      while (line_ptr < (line_end - 1) && line_ptr[0] != line_ptr[1] && count < 128)
+      {
+	line_ptr ++;
+	count ++;
+      }
+
+      *comp_ptr++ = (unsigned char)(count - 1);
+
+      memcpy(comp_ptr, start, count);
+      comp_ptr += count;
+    }
+  }
+
+  return ((size_t)(comp_ptr - dst));
+}
+
+
+//
+// 'usage()' - Show program usage.
+//
+
+static int				// O - Exit status
+usage(FILE *fp)				// I - Output file
+{
+  fputs("Usage: benchpackbits [OPTIONS] [FILENAME ...]\n", fp);
+  fputs("Options:\n", fp);
+  fputs("--help                         Show this help\n", fp);
+  fputs("-n ITERATIONS                  Set the number of iterations (default 100)\n", fp);
+  fputs("-w BYTES                       Set the line length in bytes (default 600)\n", fp);
+
+  return (fp == stdout ? 0 : 1);
+}
@@ -0,0 +1,784 @@
+//
+// PCL driver benchmark for cupslocald.
+//
+// Usage:
+//
+//   ./benchpcl [-n COPIES] [-o FILENAME] [-r RESOLUTION] [-t TYPE] [-v] [FILENAME.pwg ...]
+//
+// With no files, synthetic blank, text, graphics, and photo pages are printed
+// at 150, 300, and 600dpi using each raster type supported by the PCL driver.
+// Otherwise the pages in each PWG raster file are printed.  Each page is sent
+// through the PCL driver's raster callbacks COPIES times (default 10), and
+// the output goes to a null device or to FILENAME with "-o".
+//
+// The raster callbacks only use the job to get and set the job data and to log
+// messages, so this program includes the driver source with its own job
+// functions (see DRIVERS_JOB_HOOKS) and never creates a system, printer, or
+// job.
+//
+// Copyright © 2025 by OpenPrinting.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+#define CUPSLOCALD_MAIN_C
+#define DRIVERS_JOB_HOOKS
+#include "cupslocald.h"
+#include <stdarg.h>
+
+
+//
+// Local types...
+//
+
+typedef struct bench_page_s		// Page of raster data
+{
+  cups_page_header_t header;		// Page header
+  unsigned char	*pixels;		// Page pixels
+} bench_page_t;
+
+
+//
+// Local globals...
+//
+
+static size_t	bench_bytes = 0;	// Bytes written to the device
+static void	*bench_data = NULL;	// Job data
+static int	bench_fd = -1;		// Output file or -1 for none
+static bool	bench_verbose = false;	// Show job log messages?
+
+
+//
+// Local functions...
+//
+
+static bool	bench_pages(const char *name, pappl_pr_driver_data_t *data, bench_page_t *pages, size_t num_pages, int copies);
+static void	device_close_cb(pappl_device_t *device);
+static void	device_error_cb(const char *message, void *err_data);
+static bool	device_open_cb(pappl_device_t *device, const char *device_uri, const char *name);
+static ssize_t	device_write_cb(pappl_device_t *device, const void *buffer, size_t bytes);
+static void	*job_get_data(pappl_job_t *job);
+static pappl_printer_t *job_get_printer(pappl_job_t *job);
+static void	job_log(pappl_job_t *job, pappl_loglevel_t level, const char *message, ...) _CUPS_FORMAT(3, 4);
+static void	job_set_data(pappl_job_t *job, void *data);
+static bool	make_page(bench_page_t *page, unsigned resolution, pappl_raster_type_t type, const char *content);
+static bench_page_t *read_pages(const char *filename, size_t *num_pages);
+static int	usage(FILE *fp);
+
+
+//
+// Driver source...
+//
+
+#include "drivers.c"
+
+
+//
+// 'main()' - Main entry.
+//
+
+int					// O - Exit status
+main(int  argc,				// I - Number of command-line arguments
+     char *argv[])			// I - Command-line arguments
+{
+  int			i;		// Looping var
+  const char		*opt;		// Current option
+  int			copies = 10;	// Number of copies of each page
+  const char		*outfile = NULL;// Output file
+  unsigned		resolution = 0;	// Resolution to test or 0 for all
+  pappl_raster_type_t	type = PAPPL_RASTER_TYPE_NONE;
+					// Raster type to test or none for all
+  pappl_pr_driver_data_t data;		// PCL driver data
+  const char		**files;	// Files on command-line
+  int			num_files = 0;	// Number of files
+  int			status = 0;	// Exit status
+
+
+  if ((files = calloc((size_t)argc, sizeof(char *))) == NULL)
+  {
+    perror("benchpcl");
+    return (1);
+  }
+
+  for (i = 1; i < argc; i ++)
+  {
+    if (!strcmp(argv[i], "--help"))
+    {
+      return (usage(stdout));
+    }
+    else if (argv[i][0] == '-')
+    {
+      for (opt = argv[i] + 1; *opt; opt ++)
+      {
+        switch (*opt)
+        {
+          case 'n' : // -n COPIES
+              i ++;
+              if (i >= argc || (copies = atoi(argv[i])) < 1)
+              {
+                fputs("benchpcl: Expected number of copies after '-n'.\n", stderr);
+                return (usage(stderr));
+              }
+              break;
+
+          case 'o' : // -o FILENAME
+              i ++;
+              if (i >= argc)
+              {
+                fputs("benchpcl: Expected output filename after '-o'.\n", stderr);
+                return (usage(stderr));
+              }
+              outfile = argv[i];
+              break;
+
+          case 'r' : // -r RESOLUTION
+              i ++;
+              if (i >= argc || atoi(argv[i]) < 75 || atoi(argv[i]) > 1200)
+              {
+                fputs("benchpcl: Expected resolution after '-r'.\n", stderr);
+                return (usage(stderr));
+              }
+              resolution = (unsigned)atoi(argv[i]);
+              break;
+
+          case 't' : // -t TYPE
+              i ++;
+              if (i >= argc)
+              {
+                fputs("benchpcl: Expected raster type after '-t'.\n", stderr);
+                return (usage(stderr));
+              }
+              else if (!strcmp(argv[i], "black_1"))
+              {
+                type = PAPPL_RASTER_TYPE_BLACK_1;
+              }
+              else if (!strcmp(argv[i], "black_8"))
+              {
+                type = PAPPL_RASTER_TYPE_BLACK_8;
+              }
+              else if (!strcmp(argv[i], "sgray_8"))
+              {
+                type = PAPPL_RASTER_TYPE_SGRAY_8;
+              }
+              else
+              {
+                fprintf(stderr, "benchpcl: Unknown raster type '%s'.\n", argv[i]);
+                return (usage(stderr));
+              }
+              break;
+
+          case 'v' : // -v
+              bench_verbose = true;
+              break;
+
+          default :
+              fprintf(stderr, "benchpcl: Unknown option '-%c'.\n", *opt);
+              return (usage(stderr));
+        }
+      }
+    }
+    else
+    {
+      files[num_files ++] = argv[i];
+    }
+  }
+
+  // Get the PCL driver callbacks...
+  memset(&data, 0, sizeof(data));
+
+  if (!LocalDriverCallback(/*system*/NULL, "pcl", "bench:///", /*device_id*/NULL, &data, /*attrs*/NULL, /*cbdata*/NULL))
+  {
+    fputs("benchpcl: Unable to load the PCL driver.\n", stderr);
+    return (1);
+  }
+
+  // Send the output to the bit bucket or a file...
+  if (outfile && (bench_fd = open(outfile, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+  {
+    fprintf(stderr, "benchpcl: %s: %s\n", outfile, strerror(errno));
+    return (1);
+  }
+
+  papplDeviceAddScheme("bench", PAPPL_DEVTYPE_CUSTOM_LOCAL, /*list_cb*/NULL, device_open_cb, device_close_cb, /*read_cb*/NULL, device_write_cb, /*status_cb*/NULL, /*id_cb*/NULL);
+
+  printf("%-24s %10s %8s %10s %7s\n", "Name", "Lines/s", "Pages/s", "Bytes/Page", "Ratio");
+
+  if (num_files > 0)
+  {
+    // Benchmark PWG raster files...
+    bench_page_t	*pages;		// Pages in file
+    size_t		j,		// Looping var
+			num_pages;	// Number of pages
+
+    for (i = 0; i < num_files; i ++)
+    {
+      if ((pages = read_pages(files[i], &num_pages)) == NULL)
+      {
+        status = 1;
+        continue;
+      }
+
+      if (!bench_pages(files[i], &data, pages, num_pages, copies))
+        status = 1;
+
+      for (j = 0; j < num_pages; j ++)
+        free(pages[j].pixels);
+      free(pages);
+    }
+  }
+  else
+  {
+    // Benchmark synthetic pages...
+    size_t		r,		// Current resolution
+			t,		// Current raster type
+			c;		// Current content
+    bench_page_t	page;		// Page
+    char		name[256];	// Benchmark name
+    static const unsigned resolutions[] =
+    {					// Resolutions
+      150, 300, 600
+    };
+    static const pappl_raster_type_t types[] =
+    {					// Raster types
+      PAPPL_RASTER_TYPE_BLACK_1,
+      PAPPL_RASTER_TYPE_BLACK_8,
+      PAPPL_RASTER_TYPE_SGRAY_8
+    };
+    static const char * const type_names[] =
+    {					// Raster type names
+      "black_1",
+      "black_8",
+      "sgray_8"
+    };
+    static const char * const contents[] =
+    {					// Page contents
+      "blank",
+      "text",
+      "graphics",
+      "photo"
+    };
+
+    for (r = 0; r < (sizeof(resolutions) / sizeof(resolutions[0])); r ++)
+    {
+      if (resolution && resolution != resolutions[r])
+        continue;
+
+      for (t = 0; t < (sizeof(types) / sizeof(types[0])); t ++)
+      {
+        if ((type && type != types[t]) || !(data.raster_types & types[t]))
+          continue;
+
+        for (c = 0; c < (sizeof(contents) / sizeof(contents[0])); c ++)
+        {
+          if (!make_page(&page, resolutions[r], types[t], contents[c]))
+          {
+            status = 1;
+            continue;
+          }
+
+          snprintf(name, sizeof(name), "%udpi-%s-%s", resolutions[r], type_names[t], contents[c]);
+          if (!bench_pages(name, &data, &page, 1, copies))
+            status = 1;
+
+          free(page.pixels);
+        }
+      }
+    }
+  }
+
+  if (bench_fd >= 0)
+    close(bench_fd);
+
+  free(files);
+
+  return (status);
+}
+
+
+//
+// 'bench_pages()' - Print pages using the PCL driver and show the timing.
+//
+
+static bool				// O - `true` on success, `false` on failure
+bench_pages(
+    const char             *name,	// I - Name of benchmark
+    pappl_pr_driver_data_t *data,	// I - PCL driver data
+    bench_page_t           *pages,	// I - Pages
+    size_t                 num_pages,	// I - Number of pages
+    int                    copies)	// I - Number of copies
+{
+  int			copy;		// Current copy
+  size_t		i;		// Current page
+  unsigned		y,		// Current line
+			page = 0;	// Page number
+  const unsigned char	*line;		// Current line
+  cups_page_header_t	*header;	// Current page header
+  pappl_pr_options_t	options;	// Print options
+  pappl_device_t	*device;	// Output device
+  pappl_job_t		*job = NULL;	// No job, see job_get_data()
+  double		start,		// Start time
+			elapsed;	// Elapsed time
+  size_t		lines = 0;	// Number of lines printed
+  double		raster = 0.0;	// Uncompressed 1-bit raster bytes
+  bool			ret = true;	// Return value
+
+
+  if ((device = papplDeviceOpen("bench:///", name, device_error_cb, /*err_data*/NULL)) == NULL)
+    return (false);
+
+  // Use the first page for the job options...
+  header = &pages[0].header;
+
+  memset(&options, 0, sizeof(options));
+
+  options.header                = *header;
+  options.num_pages             = (unsigned)num_pages * (unsigned)copies;
+  options.printer_resolution[0] = (int)header->HWResolution[0];
+  options.printer_resolution[1] = (int)header->HWResolution[1];
+  options.sides                 = PAPPL_SIDES_ONE_SIDED;
+
+  cupsCopyString(options.media.size_name, "custom", sizeof(options.media.size_name));
+  cupsCopyString(options.media.source, "tray-1", sizeof(options.media.source));
+  cupsCopyString(options.media.type, "stationery", sizeof(options.media.type));
+
+  options.media.size_width    = (int)(header->cupsWidth * 2540 / header->HWResolution[0]);
+  options.media.size_length   = (int)(header->cupsHeight * 2540 / header->HWResolution[1]);
+  options.media.left_margin   = options.media.right_margin = data->left_right;
+  options.media.bottom_margin = options.media.top_margin = data->bottom_top;
+
+  memcpy(options.dither, data->gdither, sizeof(options.dither));
+
+  bench_bytes = 0;
+  start       = cupsGetClock();
+
+  if (!(data->rstartjob_cb)(job, &options, device))
+  {
+    papplDeviceClose(device);
+    return (false);
+  }
+
+  for (copy = 0; copy < copies && ret; copy ++)
+  {
+    for (i = 0; i < num_pages && ret; i ++)
+    {
+      header = &pages[i].header;
+
+      options.header                = *header;
+      options.printer_resolution[0] = (int)header->HWResolution[0];
+      options.printer_resolution[1] = (int)header->HWResolution[1];
+
+      if (!(data->rstartpage_cb)(job, &options, device, ++ page))
+      {
+        ret = false;
+        break;
+      }
+
+      for (y = 0, line = pages[i].pixels; y < header->cupsHeight && ret; y ++, line += header->cupsBytesPerLine)
+        ret = (data->rwriteline_cb)(job, &options, device, y, line);
+
+      if (!(data->rendpage_cb)(job, &options, device, page))
+        ret = false;
+
+      lines  += header->cupsHeight;
+      raster += (double)((options.printer_resolution[0] * (options.media.size_width - options.media.left_margin - options.media.right_margin) / 2540 + 7) / 8) * (options.printer_resolution[1] * (options.media.size_length - options.media.top_margin - options.media.bottom_margin) / 2540);
+    }
+  }
+
+  (data->rendjob_cb)(job, &options, device);
+
+  // Closing the device writes any buffered output...
+  papplDeviceClose(device);
+
+  elapsed = cupsGetClock() - start;
+
+  if (!ret)
+  {
+    fprintf(stderr, "benchpcl: %s: Unable to print page %u.\n", name, page);
+    return (false);
+  }
+
+  printf("%-24s %10.0f %8.2f %10lu %6.2f%%\n", name, lines / elapsed, page / elapsed, (unsigned long)(bench_bytes / page), raster > 0.0 ? 100.0 * bench_bytes / raster : 0.0);
+
+  return (true);
+}
+
+
+//
+// 'device_close_cb()' - Close the device.
+//
+
+static void
+device_close_cb(pappl_device_t *device)	// I - Device (not used)
+{
+  (void)device;
+}
+
+
+//
+// 'device_error_cb()' - Show a device error.
+//
+
+static void
+device_error_cb(const char *message,	// I - Error message
+                void       *err_data)	// I - Callback data (not used)
+{
+  (void)err_data;
+
+  fprintf(stderr, "benchpcl: %s\n", message);
+}
+
+
+//
+// 'device_open_cb()' - Open the device.
+//
+
+static bool				// O - `true` on success
+device_open_cb(pappl_device_t *device,	// I - Device (not used)
+               const char     *device_uri,
+					// I - Device URI (not used)
+               const char     *name)	// I - Job name (not used)
+{
+  (void)device;
+  (void)device_uri;
+  (void)name;
+
+  return (true);
+}
+
+
+//
+// 'device_write_cb()' - Count and optionally save the output.
+//
+
+static ssize_t				// O - Number of bytes written or -1 on error
+device_write_cb(pappl_device_t *device,	// I - Device (not used)
+                const void     *buffer,	// I - Output buffer
+                size_t         bytes)	// I - Number of bytes
+{
+  const char	*ptr;			// Pointer into buffer
+  size_t	remaining;		// Remaining bytes
+  ssize_t	written;		// Bytes written
+
+
+  (void)device;
+
+  bench_bytes += bytes;
+
+  if (bench_fd >= 0)
+  {
+    for (ptr = (const char *)buffer, remaining = bytes; remaining > 0; ptr += written, remaining -= (size_t)written)
+    {
+      if ((written = write(bench_fd, ptr, remaining)) < 0)
+      {
+        if (errno == EINTR || errno == EAGAIN)
+        {
+          written = 0;
+          continue;
+        }
+
+        return (-1);
+      }
+    }
+  }
+
+  return ((ssize_t)bytes);
+}
+
+
+//
+// 'job_get_data()' - Get the job data.
+//
+
+static void *				// O - Job data
+job_get_data(pappl_job_t *job)		// I - Job (not used)
+{
+  (void)job;
+
+  return (bench_data);
+}
+
+
+//
+// 'job_get_printer()' - Get the printer for a job.
+//
+
+static pappl_printer_t *		// O - Printer (always `NULL`)
+job_get_printer(pappl_job_t *job)	// I - Job (not used)
+{
+  (void)job;
+
+  return (NULL);
+}
+
+
+//
+// 'job_log()' - Log a job message.
+//
+
+static void
+job_log(pappl_job_t      *job,		// I - Job (not used)
+        pappl_loglevel_t level,		// I - Log level (not used)
+        const char       *message,	// I - Printf-style message
+        ...)				// I - Additional arguments as needed
+{
+  va_list	ap;			// Pointer to arguments
+
+
+  (void)job;
+  (void)level;
+
+  if (!bench_verbose)
+    return;
+
+  va_start(ap, message);
+  vfprintf(stderr, message, ap);
+  va_end(ap);
+
+  putc('\n', stderr);
+}
+
+
+//
+// 'job_set_data()' - Set the job data.
+//
+
+static void
+job_set_data(pappl_job_t *job,		// I - Job (not used)
+             void        *data)		// I - Job data
+{
+  (void)job;
+
+  bench_data = data;
+}
+
+
+//
+// 'make_page()' - Make a synthetic US Letter page.
+//
+// "content" is "blank" for an empty page, "text" for rows of 12pt glyphs,
+// "graphics" for a horizontal gray ramp, or "photo" for a noisy diagonal
+// ramp.
+//
+
+static bool				// O - `true` on success, `false` on failure
+make_page(bench_page_t        *page,	// O - Page
+          unsigned            resolution,
+					// I - Resolution
+          pappl_raster_type_t type,	// I - Raster type
+          const char          *content)	// I - Page content
+{
+  cups_page_header_t	*header = &page->header;
+					// Page header
+  unsigned		x, y,		// Current position
+			pitch = resolution / 6,
+					// Text line pitch
+			glyph_height = resolution / 10,
+					// Text glyph height
+			glyph_width = resolution / 12,
+					// Text glyph width
+			hash,		// Glyph bits
+			seed = 1;	// Random number seed
+  int			lum;		// Pixel luminance
+  unsigned char		*line;		// Current line
+
+
+  memset(header, 0, sizeof(cups_page_header_t));
+
+  header->HWResolution[0]  = resolution;
+  header->HWResolution[1]  = resolution;
+  header->cupsWidth        = resolution * 17 / 2;
+  header->cupsHeight       = resolution * 11;
+  header->cupsBitsPerColor = type == PAPPL_RASTER_TYPE_BLACK_1 ? 1 : 8;
+  header->cupsBitsPerPixel = header->cupsBitsPerColor;
+  header->cupsBytesPerLine = (header->cupsWidth * header->cupsBitsPerPixel + 7) / 8;
+  header->cupsColorSpace   = type == PAPPL_RASTER_TYPE_SGRAY_8 ? CUPS_CSPACE_SW : CUPS_CSPACE_K;
+
+  if ((page->pixels = calloc(header->cupsHeight, header->cupsBytesPerLine)) == NULL)
+  {
+    perror("benchpcl");
+    return (false);
+  }
+
+  for (y = 0, line = page->pixels; y < header->cupsHeight; y ++, line += header->cupsBytesPerLine)
+  {
+    for (x = 0; x < header->cupsWidth; x ++)
+    {
+      if (!strcmp(content, "text"))
+      {
+        // 5x8 glyph cells with a space after every eighth glyph...
+        lum = 255;
+
+        if ((y % pitch) < glyph_height && (x / glyph_width) % 9 != 8)
+        {
+          hash = ((x / glyph_width) * 7919 + (y / pitch) * 104729) * 2654435761U;
+          hash ^= hash >> 15;
+
+          if ((x % glyph_width) * 6 / glyph_width < 5 && (hash >> (((y % pitch) * 8 / glyph_height * 5 + (x % glyph_width) * 6 / glyph_width) % 32)) & 1)
+            lum = 0;
+        }
+      }
+      else if (!strcmp(content, "graphics"))
+      {
+        lum = (int)(255 * x / header->cupsWidth);
+      }
+      else if (!strcmp(content, "photo"))
+      {
+        seed = seed * 1103515245 + 12345;
+        lum  = (int)(255 * x / header->cupsWidth + 255 * y / header->cupsHeight) / 2 + (int)((seed >> 16) & 31) - 16;
+
+        if (lum < 0)
+          lum = 0;
+        else if (lum > 255)
+          lum = 255;
+      }
+      else
+      {
+        lum = 255;
+      }
+
+      if (type == PAPPL_RASTER_TYPE_BLACK_1)
+      {
+        if (lum < 128)
+          line[x / 8] |= 128 >> (x & 7);
+      }
+      else if (type == PAPPL_RASTER_TYPE_BLACK_8)
+      {
+        line[x] = (unsigned char)(255 - lum);
+      }
+      else
+      {
+        line[x] = (unsigned char)lum;
+      }
+    }
+  }
+
+  return (true);
+}
+
+
+//
+// 'read_pages()' - Read the pages in a PWG raster file.
+//
+
+static bench_page_t *			// O - Pages or `NULL` on error
+read_pages(const char *filename,	// I - PWG raster file
+           size_t     *num_pages)	// O - Number of pages
+{
+  int			fd;		// File descriptor
+  cups_raster_t		*ras;		// Raster stream
+  bench_page_t		*pages = NULL,	// Pages
+			*temp;		// New pages
+  cups_page_header_t	header;		// Page header
+  size_t		count = 0,	// Number of pages
+			alloc_pages = 0;// Allocated pages
+  bool			ret = true;	// Return value
+
+
+  *num_pages = 0;
+
+  if ((fd = open(filename, O_RDONLY)) < 0)
+  {
+    fprintf(stderr, "benchpcl: %s: %s\n", filename, strerror(errno));
+    return (NULL);
+  }
+
+  if ((ras = cupsRasterOpen(fd, CUPS_RASTER_READ)) == NULL)
+  {
+    fprintf(stderr, "benchpcl: %s: %s\n", filename, cupsGetErrorString());
+    close(fd);
+    return (NULL);
+  }
+
+  while (ret && cupsRasterReadHeader(ras, &header))
+  {
+    // The PCL driver supports 1-bit black and 8-bit black/grayscale...
+    if ((header.cupsBitsPerPixel != 1 || header.cupsColorSpace != CUPS_CSPACE_K) && (header.cupsBitsPerPixel != 8 || (header.cupsColorSpace != CUPS_CSPACE_K && header.cupsColorSpace != CUPS_CSPACE_SW && header.cupsColorSpace != CUPS_CSPACE_W)))
+    {
+      fprintf(stderr, "benchpcl: %s: Page %u is not 1-bit black or 8-bit grayscale.\n", filename, (unsigned)count + 1);
+      ret = false;
+      break;
+    }
+
+    if (header.HWResolution[0] == 0 || header.HWResolution[1] == 0 || header.cupsWidth == 0 || header.cupsHeight == 0)
+    {
+      fprintf(stderr, "benchpcl: %s: Page %u has a bad header.\n", filename, (unsigned)count + 1);
+      ret = false;
+      break;
+    }
+
+    if (count >= alloc_pages)
+    {
+      if ((temp = realloc(pages, (alloc_pages + 16) * sizeof(bench_page_t))) == NULL)
+      {
+        perror("benchpcl");
+        ret = false;
+        break;
+      }
+
+      pages       = temp;
+      alloc_pages += 16;
+    }
+
+    pages[count].header = header;
+
+    if ((pages[count].pixels = malloc((size_t)header.cupsBytesPerLine * header.cupsHeight)) == NULL)
+    {
+      perror("benchpcl");
+      ret = false;
+      break;
+    }
+
+    if (cupsRasterReadPixels(ras, pages[count].pixels, header.cupsBytesPerLine * header.cupsHeight) != header.cupsBytesPerLine * header.cupsHeight)
+    {
+      fprintf(stderr, "benchpcl: %s: Unable to read page %u.\n", filename, (unsigned)count + 1);
+      free(pages[count].pixels);
+      ret = false;
+      break;
+    }
+
+    count ++;
+  }
+
+  cupsRasterClose(ras);
+  close(fd);
+
+  if (ret && count == 0)
+  {
+    fprintf(stderr, "benchpcl: %s: No pages.\n", filename);
+    ret = false;
+  }
+
+  if (!ret)
+  {
+    while (count > 0)
+      free(pages[-- count].pixels);
+
+    free(pages);
+    return (NULL);
+  }
+
+  *num_pages = count;
+
+  return (pages);
+}
+
+
+//
+// 'usage()' - Show program usage.
+//
+
+static int				// O - Exit status
+usage(FILE *fp)				// I - Output file
+{
+  fputs("Usage: benchpcl [OPTIONS] [FILENAME.pwg ...]\n", fp);
+  fputs("Options:\n", fp);
+  fputs("--help                         Show this help\n", fp);
+  fputs("-n COPIES                      Set the number of copies of each page (default 10)\n", fp);
+  fputs("-o FILENAME                    Save the PCL output to a file\n", fp);
+  fputs("-r RESOLUTION                  Only test RESOLUTION dpi (150, 300, or 600)\n", fp);
+  fputs("-t TYPE                        Only test raster TYPE (black_1, black_8, or sgray_8)\n", fp);
+  fputs("-v                             Show driver log messages\n", fp);
+
+  return (fp == stdout ? 0 : 1);
+}
@@ -13,6 +13,38 @@
 #  include <pappl/pappl.h>
 
 
+//
+// Constants...
+//
+
+#  define LOCAL_IDLE_SHUTDOWN	120	// Idle shutdown time in seconds
+#  define LOCAL_MIN_OUTPUT	1024	// Minimum printer output buffer size
+#  define LOCAL_WORKER_IDLE	(LOCAL_IDLE_SHUTDOWN / 2)
+					// Transform worker idle time in seconds
+
+
+//
+// Types...
+//
+
+typedef enum local_metric_e		// Metrics
+{
+  LOCAL_METRIC_DEVICE_WRITE,		// Device write time in seconds
+  LOCAL_METRIC_JOB_BYTES,		// Bytes sent to the device per document
+  LOCAL_METRIC_PAGE_PCL,		// PCL page render time in seconds
+  LOCAL_METRIC_PAGE_PS,			// PostScript page render time in seconds
+  LOCAL_METRIC_PCL_INPUT,		// PCL raster bytes before compression
+  LOCAL_METRIC_PCL_OUTPUT,		// PCL raster bytes after compression
+  LOCAL_METRIC_PROBE,			// IPP Everywhere probe time in seconds
+  LOCAL_METRIC_TRANSFORM_CACHE_HIT,	// Transform cache bytes sent
+  LOCAL_METRIC_TRANSFORM_CACHE_STORE,	// Transform cache bytes saved
+  LOCAL_METRIC_TRANSFORM_SPAWN,		// Transform start time in seconds
+  LOCAL_METRIC_TRANSFORM_TIME,		// Transform run time in seconds
+  LOCAL_METRIC_TRANSFORM_WAIT,		// Transform queue wait time in seconds
+  LOCAL_METRIC_MAX			// Number of metrics
+} local_metric_t;
+
+
 //
 // Globals...
 //
@@ -38,12 +70,20 @@ VAR pappl_pr_driver_t	LocalDrivers[7]
 }
 #  endif // CUPSLOCALD_MAIN_C
 ;
+VAR size_t		LocalOutputBuffer VALUE(65536);
+					// Printer output buffer size in bytes
 VAR char		LocalSocket[256] VALUE("");
 					// Domain socket path
 VAR char		LocalSpoolDir[256] VALUE("");
 					// Spool directory
 VAR char		LocalStateFile[256] VALUE("");
 					// State file
+VAR size_t		LocalTransformCache VALUE(67108864);
+					// Transform cache size in bytes (0 to disable)
+VAR int			LocalTransformLimit VALUE(0);
+					// Maximum number of concurrent transforms (0 for one per CPU)
+VAR int			LocalTransformWorkers VALUE(2);
+					// Number of transform worker processes
 
 
 //
@@ -54,9 +94,16 @@ VAR char		LocalStateFile[256] VALUE("");
 extern void		*LocalDBusService(void *data);
 #  endif // HAVE_DBUS
 
+extern void		LocalDitherLine(unsigned char *dst, const unsigned char *src, unsigned width, const unsigned char *dither, unsigned offset, bool black);
 extern const char	*LocalDriverAutoAdd(const char *device_info, const char *device_uri, const char *device_id, void *data);
 extern bool		LocalDriverCallback(pappl_system_t *system, const char *driver_name, const char *device_uri, const char *device_id, pappl_pr_driver_data_t *driver_data, ipp_t **driver_attrs, void *data);
+extern void		LocalDriverShutdown(void);
+extern void		LocalMetricsAdd(local_metric_t metric, size_t count, double sum);
+extern void		LocalMetricsAddDevice(pappl_device_t *device, pappl_devmetrics_t *start);
+extern bool		LocalMetricsCallback(pappl_client_t *client, pappl_system_t *system);
+extern size_t		LocalPackBits(unsigned char *dst, const unsigned char *src, size_t length);
 extern bool		LocalTransformFilter(pappl_job_t *job, int doc_number, pappl_pr_options_t *options, pappl_device_t *device, void *data);
+extern bool		LocalTransformTimer(pappl_system_t *system, void *data);
 
 
 #endif // !CUPSLOCALD_H
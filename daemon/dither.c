@@ -0,0 +1,236 @@
+//
+// Dithering support for cupslocald.
+//
+// Copyright © 2025 by OpenPrinting.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+#include "cupslocald.h"
+#if defined(__x86_64__) && defined(__GNUC__)
+#  include <immintrin.h>
+#  define LOCAL_DITHER_X86 1
+#elif defined(__aarch64__)
+#  include <arm_neon.h>
+#  define LOCAL_DITHER_NEON 1
+#endif // __x86_64__ && __GNUC__
+
+
+//
+// Local functions...
+//
+
+static void	dither_scalar(unsigned char *dst, const unsigned char *src, unsigned width, const unsigned char *drow, bool black);
+#ifdef LOCAL_DITHER_X86
+static unsigned	dither_avx2(unsigned char *dst, const unsigned char *src, unsigned width, const unsigned char *drow, bool black);
+static unsigned	dither_sse2(unsigned char *dst, const unsigned char *src, unsigned width, const unsigned char *drow, bool black);
+#elif defined(LOCAL_DITHER_NEON)
+static unsigned	dither_neon(unsigned char *dst, const unsigned char *src, unsigned width, const unsigned char *drow, bool black);
+#endif // LOCAL_DITHER_X86
+
+
+//
+// 'LocalDitherLine()' - Dither a line of 8-bit pixels to 1-bit pixels.
+//
+// The "dither" argument is a row from a 16x16 dither matrix, and "offset" is
+// the column of the first pixel so that the matrix lines up with the page.
+// When "black" is `true` the pixels are black values (0 = white) and a bit
+// is set when the pixel is greater than or equal to the dither value,
+// otherwise the pixels are luminance values (0 = black) and a bit is set
+// when the pixel is less than the dither value.
+//
+// The destination buffer must hold `(width + 7) / 8` bytes, all of which are
+// written.
+//
+
+void
+LocalDitherLine(
+    unsigned char       *dst,		// I - Destination (1-bit) line
+    const unsigned char *src,		// I - Source (8-bit) pixels
+    unsigned            width,		// I - Number of pixels
+    const unsigned char *dither,	// I - Dither row (16 values)
+    unsigned            offset,		// I - Column of first pixel
+    bool                black)		// I - `true` for black, `false` for gray
+{
+  unsigned	i,			// Looping var
+		count = 0;		// Number of pixels done
+  unsigned char	drow[32];		// Dither row aligned to first pixel
+
+
+  // Rotate the dither row so that drow[0] applies to src[0]...
+  for (i = 0; i < 32; i ++)
+    drow[i] = dither[(offset + i) & 15];
+
+  // Use the fastest kernel available, then finish with the scalar code...
+#ifdef LOCAL_DITHER_X86
+  if (__builtin_cpu_supports("avx2"))
+    count = dither_avx2(dst, src, width, drow, black);
+  else
+    count = dither_sse2(dst, src, width, drow, black);
+#elif defined(LOCAL_DITHER_NEON)
+  count = dither_neon(dst, src, width, drow, black);
+#endif // LOCAL_DITHER_X86
+
+  if (count < width)
+    dither_scalar(dst + count / 8, src + count, width - count, drow, black);
+}
+
+
+#ifdef LOCAL_DITHER_X86
+//
+// 'dither_avx2()' - Dither 32 pixels at a time using AVX2.
+//
+
+__attribute__((target("avx2")))
+static unsigned				// O - Number of pixels dithered
+dither_avx2(unsigned char       *dst,	// I - Destination line
+            const unsigned char *src,	// I - Source pixels
+            unsigned            width,	// I - Number of pixels
+            const unsigned char *drow,	// I - Aligned dither row
+            bool                black)	// I - `true` for black, `false` for gray
+{
+  unsigned	count;			// Number of pixels done
+  unsigned	mask;			// Comparison mask
+  __m256i	d = _mm256_loadu_si256((const __m256i *)drow),
+					// Dither values
+		p;			// Pixel values
+  static const unsigned char reverse[32] =
+  {					// Reverse the pixels in each group of 8
+    7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+    7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8
+  };
+  __m256i	r = _mm256_loadu_si256((const __m256i *)reverse);
+					// Shuffle control
+
+
+  for (count = 0; (count + 32) <= width; count += 32, src += 32, dst += 4)
+  {
+    // Compare "p >= d" as "max(p, d) == p", then reverse each group of 8 so
+    // the first pixel ends up in the most significant bit of each byte...
+    p    = _mm256_loadu_si256((const __m256i *)src);
+    p    = _mm256_shuffle_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(p, d), p), r);
+    mask = (unsigned)_mm256_movemask_epi8(p);
+
+    if (!black)
+      mask = ~mask;
+
+    dst[0] = (unsigned char)mask;
+    dst[1] = (unsigned char)(mask >> 8);
+    dst[2] = (unsigned char)(mask >> 16);
+    dst[3] = (unsigned char)(mask >> 24);
+  }
+
+  return (count);
+}
+
+
+//
+// 'dither_sse2()' - Dither 16 pixels at a time using SSE2.
+//
+
+static unsigned				// O - Number of pixels dithered
+dither_sse2(unsigned char       *dst,	// I - Destination line
+            const unsigned char *src,	// I - Source pixels
+            unsigned            width,	// I - Number of pixels
+            const unsigned char *drow,	// I - Aligned dither row
+            bool                black)	// I - `true` for black, `false` for gray
+{
+  unsigned	count;			// Number of pixels done
+  unsigned	mask;			// Comparison mask
+  __m128i	d = _mm_loadu_si128((const __m128i *)drow),
+					// Dither values
+		p;			// Pixel values
+
+
+  for (count = 0; (count + 16) <= width; count += 16, src += 16, dst += 2)
+  {
+    p    = _mm_loadu_si128((const __m128i *)src);
+    mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(p, d), p));
+
+    if (!black)
+      mask = ~mask;
+
+    // SSE2 has no byte shuffle, so reverse the bits after the movemask...
+    dst[0] = (unsigned char)((((mask & 255) * 0x80200802ULL) & 0x0884422110ULL) * 0x0101010101ULL >> 32);
+    dst[1] = (unsigned char)(((((mask >> 8) & 255) * 0x80200802ULL) & 0x0884422110ULL) * 0x0101010101ULL >> 32);
+  }
+
+  return (count);
+}
+
+
+#elif defined(LOCAL_DITHER_NEON)
+//
+// 'dither_neon()' - Dither 16 pixels at a time using NEON.
+//
+
+static unsigned				// O - Number of pixels dithered
+dither_neon(unsigned char       *dst,	// I - Destination line
+            const unsigned char *src,	// I - Source pixels
+            unsigned            width,	// I - Number of pixels
+            const unsigned char *drow,	// I - Aligned dither row
+            bool                black)	// I - `true` for black, `false` for gray
+{
+  unsigned	count;			// Number of pixels done
+  uint8x16_t	d = vld1q_u8(drow),	// Dither values
+		p;			// Pixel values
+  static const unsigned char weights[16] =
+  {					// Bit for each pixel
+    128, 64, 32, 16, 8, 4, 2, 1, 128, 64, 32, 16, 8, 4, 2, 1
+  };
+  uint8x16_t	w = vld1q_u8(weights);	// Bit weights
+
+
+  for (count = 0; (count + 16) <= width; count += 16, src += 16, dst += 2)
+  {
+    // NEON has no movemask, so add up the bit weights for each group of 8...
+    if (black)
+      p = vandq_u8(vcgeq_u8(vld1q_u8(src), d), w);
+    else
+      p = vandq_u8(vcltq_u8(vld1q_u8(src), d), w);
+
+    dst[0] = vaddv_u8(vget_low_u8(p));
+    dst[1] = vaddv_u8(vget_high_u8(p));
+  }
+
+  return (count);
+}
+#endif // LOCAL_DITHER_X86
+
+
+//
+// 'dither_scalar()' - Dither pixels one at a time.
+//
+
+static void
+dither_scalar(
+    unsigned char       *dst,		// I - Destination line
+    const unsigned char *src,		// I - Source pixels
+    unsigned            width,		// I - Number of pixels
+    const unsigned char *drow,		// I - Aligned dither row
+    bool                black)		// I - `true` for black, `false` for gray
+{
+  unsigned	x;			// Current column
+  unsigned char	bit,			// Current bit
+		byte;			// Current byte
+
+
+  for (x = 0, bit = 128, byte = 0; x < width; x ++, src ++)
+  {
+    if ((*src >= drow[x & 15]) == black)
+      byte |= bit;
+
+    if (bit == 1)
+    {
+      *dst++ = byte;
+      byte   = 0;
+      bit    = 128;
+    }
+    else
+      bit /= 2;
+  }
+
+  if (bit < 128)
+    *dst = byte;
+}
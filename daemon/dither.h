@@ -0,0 +1,47 @@
+//
+// Gamma-corrected dither matrices for cupslocald.
+//
+// This file is generated by "makedither" - do not edit.
+//
+// Graphics gamma 0.4545, photo gamma 0.4545, default matrix.
+//
+
+static const unsigned char local_gdither[16][16] =
+{
+  {  59,  24,  79,  94,  60, 123,  36, 107, 130,  25,  86,  49,  33,  18,  43, 222 },
+  {  12,  52, 183, 155,  16, 213,  84,   9,  19,  56, 152, 101, 122,  77,   6,  98 },
+  {  68, 108,  40,   7,  32, 103,  66,  45, 143,  72, 203,  11,  62,  27, 165, 142 },
+  {  20, 131,  87,  72, 118,  55,  26, 177,  93,  31,   1, 110,  39, 187,  83,  34 },
+  {   1, 194,  28,  47, 167,   3, 133,  14, 116,  53,  81, 135,  16,  47, 118,  56 },
+  { 156,  96,  61,  18, 144,  90,  77,  35, 197,  43, 161,  24,  68,  91,   8,  74 },
+  {  42, 124,  10, 235,  38,  22, 108,  61,   6,  20, 100,  55, 227, 106, 141,  29 },
+  {  52, 109,  81,  66, 102,  50, 175,  70, 146,  84, 127,   4,  36,  13, 181,  22 },
+  { 170,  15,  35,   6, 134,  29,   9, 121,  45,  30,  59, 153,  78,  44,  65,  87 },
+  { 137,  71, 192,  93, 158,  58,  17, 206,  97,  12, 174, 113,  26, 126, 102,   3 },
+  {  57, 117,  25,  46,  76, 115,  88,  39,  23,  74,  51,  90,  17, 209,  49,  31 },
+  {   8,  38, 151,  19,   0,  33, 164,  65, 125, 185,   2,  37,  69,  10, 162,  80 },
+  { 200, 105,  64, 129, 217,  54,  82,   7, 138, 104,  58, 149, 120,  42, 132,  95 },
+  {  14,  48,  85,  11,  97, 111,  27,  15,  46,  32,  21,  79,  99,  28,  63,  23 },
+  { 147, 172,  30,  70,  41, 179, 148,  63,  92, 255, 114,  13, 190,  53,   2,  73 },
+  {  37, 119,   5, 140,  21,  50,   4,  75, 168,  41,   5,  67, 159, 136,  89, 112 }
+};
+
+static const unsigned char local_pdither[16][16] =
+{
+  {  59,  24,  79,  94,  60, 123,  36, 107, 130,  25,  86,  49,  33,  18,  43, 222 },
+  {  12,  52, 183, 155,  16, 213,  84,   9,  19,  56, 152, 101, 122,  77,   6,  98 },
+  {  68, 108,  40,   7,  32, 103,  66,  45, 143,  72, 203,  11,  62,  27, 165, 142 },
+  {  20, 131,  87,  72, 118,  55,  26, 177,  93,  31,   1, 110,  39, 187,  83,  34 },
+  {   1, 194,  28,  47, 167,   3, 133,  14, 116,  53,  81, 135,  16,  47, 118,  56 },
+  { 156,  96,  61,  18, 144,  90,  77,  35, 197,  43, 161,  24,  68,  91,   8,  74 },
+  {  42, 124,  10, 235,  38,  22, 108,  61,   6,  20, 100,  55, 227, 106, 141,  29 },
+  {  52, 109,  81,  66, 102,  50, 175,  70, 146,  84, 127,   4,  36,  13, 181,  22 },
+  { 170,  15,  35,   6, 134,  29,   9, 121,  45,  30,  59, 153,  78,  44,  65,  87 },
+  { 137,  71, 192,  93, 158,  58,  17, 206,  97,  12, 174, 113,  26, 126, 102,   3 },
+  {  57, 117,  25,  46,  76, 115,  88,  39,  23,  74,  51,  90,  17, 209,  49,  31 },
+  {   8,  38, 151,  19,   0,  33, 164,  65, 125, 185,   2,  37,  69,  10, 162,  80 },
+  { 200, 105,  64, 129, 217,  54,  82,   7, 138, 104,  58, 149, 120,  42, 132,  95 },
+  {  14,  48,  85,  11,  97, 111,  27,  15,  46,  32,  21,  79,  99,  28,  63,  23 },
+  { 147, 172,  30,  70,  41, 179, 148,  63,  92, 255, 114,  13, 190,  53,   2,  73 },
+  {  37, 119,   5, 140,  21,  50,   4,  75, 168,  41,   5,  67, 159, 136,  89, 112 }
+};
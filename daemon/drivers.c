@@ -9,14 +9,65 @@
 
 #include "cupslocald.h"
 #include <cups/thread.h>
+#include "dither.h"
 #include "icons.h"
-#include <math.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+
+
+//
+// Local constants...
+//
+
+#define EVE_APPLY_WAIT	30		// Seconds to wait for a new printer to be added
+#define EVE_MAX_PROBES	8		// Maximum number of concurrent printer probes
+#define EVE_PROBE_RETRIES 5		// Number of times to retry a failed probe for a new printer
+#define EVE_PROBE_RETRY	30		// Seconds between retries, multiplied by the retry number
+#define EVE_PROBE_TIMEOUT 10000		// Timeout for each printer probe in milliseconds
+#define EVE_PROBE_WAIT	5.0		// Seconds to wait for a new printer's capabilities
+#define PCLPS_CHUNK	1048576		// Bytes per write when printing raw files
+#define STRING_POOL	4096		// Number of string pool slots (power of 2)
+
+
+//
+// Job functions used by the drivers - the PCL driver benchmark includes this
+// file and defines DRIVERS_JOB_HOOKS to provide its own, so that it does not
+// need a system, printer, and job...
+//
+
+#ifndef DRIVERS_JOB_HOOKS
+#  define job_get_data		papplJobGetData
+#  define job_get_printer	papplJobGetPrinter
+#  define job_log		papplLogJob
+#  define job_set_data		papplJobSetData
+#endif // !DRIVERS_JOB_HOOKS
 
 
 //
 // Local types...
 //
 
+typedef struct eve_thread_s		// IPP Everywhere probe thread
+{
+  struct eve_thread_s *next;		// Next thread
+  cups_thread_t	thread;			// Thread
+  bool		finished;		// Has the thread finished?
+} eve_thread_t;
+
+typedef struct eve_cache_s		// IPP Everywhere cache revalidation data
+{
+  pappl_system_t *system;		// System
+  eve_thread_t	*thread;		// Probe thread
+  char		device_uri[1024],	// Device URI
+		filename[1024];		// Cache filename
+  int		config_change_time;	// Cached printer-config-change-time value
+  size_t	updated;		// Number of printers updated
+  ipp_t		*response;		// Current printer attributes
+  bool		waiting,		// Is the driver callback waiting for the response?
+		done,			// Has the probe finished?
+		generic;		// Is the printer using generic capabilities?
+} eve_cache_t;
+
 typedef struct pcl_data_s		// PCL job data
 {
   unsigned	width,			// Width
@@ -26,10 +77,31 @@ typedef struct pcl_data_s		// PCL job data
 		ystart,			// First line on page
 		yend;			// Last line on page
   int		compression;		// Compression mode
-  size_t	line_size;		// Size of output line
+  size_t	line_size,		// Size of output line
+		max_line_size;		// Size of line buffers
   unsigned char	*line_buffer,		// Line buffer
-		*comp_buffer;		// Compression buffer
+		*comp_buffer,		// PackBits compression buffer
+		*delta_buffer,		// Delta row compression buffer
+		*seed_buffer;		// Seed row (last line sent)
   unsigned	feed;			// Number of lines to skip
+  bool		out_error;		// Error writing output?
+  size_t	out_size,		// Size of output buffer
+		out_used;		// Bytes in output buffer
+  unsigned char	*out_buffer;		// Output buffer
+  int		source_code,		// PCL media source or -1
+		size_code,		// PCL page size or -1
+		type_code;		// PCL media type or -1
+  unsigned	setup_resolution,	// Resolution used for setup commands
+		setup_width,		// Width used for setup commands
+		setup_height;		// Height used for setup commands
+  size_t	front_length,		// Length of front side setup commands
+		back_length;		// Length of back side setup commands
+  char		front_setup[256],	// Front side page setup commands
+		back_setup[128];	// Back side page setup commands
+  double	page_start;		// Time when the page was started
+  size_t	raster_bytes,		// Raster bytes on page before compression
+		comp_bytes;		// Raster bytes on page after compression
+  pappl_devmetrics_t devmetrics;	// Device metrics at start of job
 } pcl_data_t;
 
 typedef struct pcl_map_s		// PWG name to PCL code map
@@ -38,6 +110,23 @@ typedef struct pcl_map_s		// PWG name to PCL code map
   int		value;			// Value
 } pcl_map_t;
 
+typedef struct ps_data_s		// PostScript job data
+{
+  unsigned	pages;			// Number of pages
+  size_t	line_size,		// Bytes per line
+		comp_size;		// Size of compression buffer
+  unsigned char	*comp_buffer;		// RunLength compression buffer
+  unsigned char	a85_buffer[4];		// Pending ASCII85 bytes
+  unsigned	a85_count,		// Number of pending ASCII85 bytes
+		a85_column;		// Current output column
+  bool		out_error;		// Error writing output?
+  size_t	out_size,		// Size of output buffer
+		out_used;		// Bytes in output buffer
+  char		*out_buffer;		// Output buffer
+  double	page_start;		// Time when the page was started
+  pappl_devmetrics_t devmetrics;	// Device metrics at start of job
+} ps_data_t;
+
 
 
 
@@ -45,8 +134,23 @@ typedef struct pcl_map_s		// PWG name to PCL code map
 // Local globals...
 //
 
-static cups_array_t	*string_pool = NULL;
+static cups_cond_t	eve_cond = CUPS_COND_INITIALIZER;
+					// Probe condition
+static cups_mutex_t	eve_mutex = CUPS_MUTEX_INITIALIZER;
+					// Probe mutex
+static size_t		eve_probes = 0;	// Number of active probes
+static bool		eve_shutdown = false;
+					// Stop probing printers?
+static eve_thread_t	*eve_threads = NULL;
+					// Probe threads
+static _Atomic(const char *) string_pool[STRING_POOL];
+					// Interned strings
+static atomic_bool	string_seeded = false;
+					// Have the constant strings been added?
+static cups_array_t	*string_overflow = NULL;
+					// Strings that don't fit in the pool
 static cups_mutex_t	string_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for overflow strings
 static const char * const pclps_media[] =
 {       // Supported media sizes for Generic PCL/PostScript printers
   "na_ledger_11x17in",
@@ -63,12 +167,82 @@ static const char * const pclps_media[] =
   "iso_dl_110x220mm",
   "na_monarch_3.875x7.5in"
 };
+static const pcl_map_t pcl_sizes[] =	// PCL media size values
+{
+  { "iso_a3_297x420mm",		27 },
+  { "iso_a4_210x297mm",		26 },
+  { "iso_a5_148x210mm",		25 },
+  { "iso_b5_176x250mm",		100 },
+  { "iso_c5_162x229mm",		91 },
+  { "iso_dl_110x220mm",		90 },
+  { "jis_b5_182x257mm",		45 },
+  { "na_executive_7x10in",		1 },
+  { "na_ledger_11x17in",		6 },
+  { "na_legal_8.5x14in",		3 },
+  { "na_letter_8.5x11in",		2 },
+  { "na_monarch_3.875x7.5in",		80 },
+  { "na_number-10_4.125x9.5in",	81 }
+};
+static const pcl_map_t pcl_sources[] =// PCL media source values
+{
+  { "auto",		7 },
+  { "by-pass-tray",	4 },
+  { "disc",		14 },
+  { "envelope",	6 },
+  { "large-capacity",	5 },
+  { "main",		1 },
+  { "manual",		2 },
+  { "right",		8 },
+  { "tray-1",		20 },
+  { "tray-2",		21 },
+  { "tray-3",		22 },
+  { "tray-4",		23 },
+  { "tray-5",		24 },
+  { "tray-6",		25 },
+  { "tray-7",		26 },
+  { "tray-8",		27 },
+  { "tray-9",		28 },
+  { "tray-10",	29 },
+  { "tray-11",	30 },
+  { "tray-12",	31 },
+  { "tray-13",	32 },
+  { "tray-14",	33 },
+  { "tray-15",	34 },
+  { "tray-16",	35 },
+  { "tray-17",	36 },
+  { "tray-18",	37 },
+  { "tray-19",	38 },
+  { "tray-20",	39 }
+};
+static const pcl_map_t pcl_data_types[] =	// PCL media type values
+{
+  { "disc",			7 },
+  { "photographic",		3 },
+  { "stationery-inkjet",	2 },
+  { "stationery",		0 },
+  { "transparency",		4 }
+};
 
 
 //
 // Local functions...
 //
 
+static const char *add_string(const char *s, bool copy);
+
+static void	eve_cache_probe(eve_cache_t *cache);
+static ipp_t	*eve_cache_read(const char *device_uri, char *filename, size_t filesize);
+static ssize_t	eve_cache_read_cb(cups_file_t *fp, ipp_uchar_t *buffer, size_t bytes);
+static void	*eve_cache_update(eve_cache_t *cache);
+static void	eve_cache_update_printer(pappl_printer_t *printer, eve_cache_t *cache);
+static void	eve_cache_write(const char *filename, ipp_t *response);
+static ssize_t	eve_cache_write_cb(cups_file_t *fp, ipp_uchar_t *buffer, size_t bytes);
+static void	eve_copy_capabilities(pappl_pr_driver_data_t *data, ipp_t *response);
+static ipp_t	*eve_default_attributes(void);
+static bool	eve_get_attributes(pappl_system_t *system, const char *device_uri, const char *requested, ipp_t **response);
+static bool	eve_probe(pappl_system_t *system, const char *device_uri, const char *filename, int config_change_time, double timeout, ipp_t **response);
+static void	eve_threads_join(bool all);
+static bool	eve_wait(double timeout);
 #if 0
 static bool	eve_rendjob(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device);
 static bool	eve_rendpage(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device, unsigned page);
@@ -82,21 +256,29 @@ static bool	eve_update_status(pappl_printer_t *printer, pappl_device_t *device);
 static const char *get_string(const char *s);
 
 static void	pcl_compress_data(pcl_data_t *pcl, pappl_device_t *device, unsigned y, const unsigned char *line, unsigned length);
+static size_t	pcl_delta_row(unsigned char *dst, const unsigned char *line, const unsigned char *seed, size_t length, size_t limit);
+static bool	pcl_flush(pcl_data_t *pcl, pappl_device_t *device);
+static int	pcl_lookup(const pcl_map_t *map, size_t num_map, const char *keyword);
+static void	pcl_make_setup(pcl_data_t *pcl, pappl_pr_options_t *options);
 static bool	pcl_rendjob(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device);
 static bool	pcl_rendpage(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device, unsigned page);
 static bool	pcl_rstartjob(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device);
 static bool	pcl_rstartpage(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device, unsigned page);
 static bool	pcl_rwriteline(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device, unsigned y, const unsigned char *pixels);
+static void	pcl_write(pcl_data_t *pcl, pappl_device_t *device, const void *data, size_t length);
 
 static bool	pclps_print(pappl_job_t *job, int doc_number, pappl_pr_options_t *options, pappl_device_t *device);
 static bool	pclps_status(pappl_printer_t *printer);
 static bool	pclps_update_status(pappl_printer_t *printer, pappl_device_t *device);
 
+static void	ps_ascii85(ps_data_t *ps, pappl_device_t *device, const unsigned char *data, size_t length, bool eod);
+static bool	ps_flush(ps_data_t *ps, pappl_device_t *device);
 static bool	ps_rendjob(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device);
 static bool	ps_rendpage(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device, unsigned page);
 static bool	ps_rstartjob(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device);
 static bool	ps_rstartpage(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device, unsigned page);
 static bool	ps_rwriteline(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device, unsigned y, const unsigned char *pixels);
+static void	ps_write(ps_data_t *ps, pappl_device_t *device, const char *data, size_t length);
 
 
 //
@@ -161,41 +343,16 @@ LocalDriverCallback(
     ipp_t                  **attrs,	// O - Printer driver attributes (unused)
     void                   *cbdata)	// I - Callback data (unused)
 {
-  size_t   		i, j;		// Looping variables
-  static pappl_dither_t	dither =	// Blue-noise dither array
-  {
-    { 111,  49, 142, 162, 113, 195,  71, 177, 201,  50, 151,  94,  66,  37,  85, 252 },
-    {  25,  99, 239, 222,  32, 250, 148,  19,  38, 106, 220, 170, 194, 138,  13, 167 },
-    { 125, 178,  79,  15,  65, 173, 123,  87, 213, 131, 247,  23, 116,  54, 229, 212 },
-    {  41, 202, 152, 132, 189, 104,  53, 236, 161,  62,   1, 181,  77, 241, 147,  68 },
-    {   2, 244,  56,  91, 230,   5, 204,  28, 187, 101, 144, 206,  33,  92, 190, 107 },
-    { 223, 164, 114,  36, 214, 156, 139,  70, 245,  84, 226,  48, 126, 158,  17, 135 },
-    {  83, 196,  21, 254,  76,  45, 179, 115,  12,  40, 169, 105, 253, 176, 211,  59 },
-    { 100, 180, 145, 122, 172,  97, 235, 129, 215, 149, 199,   8,  72,  26, 238,  44 },
-    { 232,  31,  69,  11, 205,  58,  18, 193,  88,  60, 112, 221, 140,  86, 120, 153 },
-    { 208, 130, 243, 160, 224, 110,  34, 248, 165,  24, 234, 184,  52, 198, 171,   6 },
-    { 108, 188,  51,  89, 137, 186, 154,  78,  47, 134,  98, 157,  35, 249,  95,  63 },
-    {  16,  75, 219,  39,   0,  67, 228, 121, 197, 240,   3,  74, 127,  20, 227, 143 },
-    { 246, 175, 119, 200, 251, 103, 146,  14, 209, 174, 109, 218, 192,  82, 203, 163 },
-    {  29,  93, 150,  22, 166, 182,  55,  30,  90,  64,  42, 141, 168,  57, 117,  46 },
-    { 216, 233,  61, 128,  81, 237, 217, 118, 159, 255, 185,  27, 242, 102,   4, 133 },
-    {  73, 191,   9, 210,  43,  96,   7, 136, 231,  80,  10, 124, 225, 207, 155, 183 }
-  };
+  size_t   		i;		// Looping variable
 
 
   (void)device_id;
   (void)attrs;
   (void)cbdata;
 
-  // Dither arrays...
-  for (i = 0; i < 16; i ++)
-  {
-    // Apply gamma correction to dither array...
-    for (j = 0; j < 16; j ++)
-      data->gdither[i][j] = 255 - (int)(255.0 * pow(1.0 - dither[i][j] / 255.0, 0.4545));
-  }
-
-  memcpy(data->pdither, data->gdither, sizeof(data->pdither));
+  // Dither arrays, gamma corrected by "makedither"...
+  memcpy(data->gdither, local_gdither, sizeof(data->gdither));
+  memcpy(data->pdither, local_pdither, sizeof(data->pdither));
 
   // orientation-requested-default and quality-default
   data->orient_default  = IPP_ORIENT_NONE;
@@ -204,414 +361,38 @@ LocalDriverCallback(
   // Printer-specific capabilities...
   if (!strcmp(driver_name, "everywhere"))
   {
-    // Query the printer for capabilities...
-    http_t		*http;		// HTTP connection
-    char		scheme[32],	// URI scheme
-			userpass[256],	// URI username:password (not used)
-			host[256],	// URI hostname
-			resource[256];	// URI resource path
-    int			port;		// URI port
-    http_encryption_t	encryption;	// Encryption to use
-    ipp_t		*request,	// IPP request
-			*response;	// IPP response
-    ipp_attribute_t	*attr;		// Supported/default attribute
-    size_t		count;		// Number of values
-    pwg_media_t		*pwg;		// Media info
-    const char		*keyword;	// Source/type
-
-    // Connect to the printer and get its capabilities...
-    httpSeparateURI(HTTP_URI_CODING_ALL, device_uri, scheme, sizeof(scheme), userpass, sizeof(userpass), host, sizeof(host), &port, resource, sizeof(resource));
-    if (port == 443 || !strcmp(scheme, "ipps"))
-      encryption = HTTP_ENCRYPTION_ALWAYS;
-    else
-      encryption = HTTP_ENCRYPTION_IF_REQUESTED;
-
-    if ((http = httpConnect(host, port, /*addrlist*/NULL, AF_UNSPEC, encryption, /*blocking*/true, 30000, /*cancel*/NULL)) == NULL)
-    {
-      papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to connect to IPP printer '%s': %s", device_uri, cupsGetErrorString());
-      return (false);
-    }
-
-    request = ippNewRequest(IPP_OP_GET_PRINTER_ATTRIBUTES);
-    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, device_uri);
-
-    response = cupsDoRequest(http, request, resource);
-
-    // Copy over capabilities...
-    // Make and model name
-    if ((attr = ippFindAttribute(response, "printer-make-and-model", IPP_TAG_TEXT)) != NULL)
-      cupsCopyString(data->make_and_model, ippGetString(attr, 0, NULL), sizeof(data->make_and_model));
-    else
-      cupsCopyString(data->make_and_model, "Generic IPP Printer", sizeof(data->make_and_model));
-
-    // Native format
-    attr = ippFindAttribute(response, "document-format-supported", IPP_TAG_MIMETYPE);
-    if (ippContainsString(attr, "application/pdf"))
-      data->format = "application/pdf";
-    else if (ippContainsString(attr, "image/urf"))
-      data->format = "image/urf";
-    else if (ippContainsString(attr, "image/pwg-raster"))
-      data->format = "image/pwg-raster";
-
-    // pages-per-minute[-color]
-    data->ppm       = ippGetInteger(ippFindAttribute(response, "pages-per-minute", IPP_TAG_INTEGER), 0);
-    data->ppm_color = ippGetInteger(ippFindAttribute(response, "pages-per-minute-color", IPP_TAG_INTEGER), 0);
-
-    // Resolutions
-    if ((attr = ippFindAttribute(response, "pwg-raster-document-resolution-supported", IPP_TAG_RESOLUTION)) != NULL)
-    {
-      ipp_res_t units;			// Units
-
-      if ((count = ippGetCount(attr)) > PAPPL_MAX_RESOLUTION)
-      {
-        i                    = count - PAPPL_MAX_RESOLUTION + 1;
-        data->num_resolution = PAPPL_MAX_RESOLUTION;
-      }
-      else
-      {
-        i                    = 0;
-        data->num_resolution = count;
-      }
-
-      for (j = 0; i < count; i ++, j ++)
-        data->x_resolution[j] = ippGetResolution(attr, i, data->y_resolution + j, &units);
-    }
-    else if ((attr = ippFindAttribute(response, "urf-supported", IPP_TAG_KEYWORD)) != NULL)
-    {
-      const char	*rs,		// Raster resolution value
-			*rsptr;		// Pointer into value
-
-      for (i = 0, count = ippGetCount(attr); i < count; i ++)
-      {
-        // Look for a resolution (RS) keyword...
-        rs = ippGetString(attr, i, NULL);
-        if (strncmp(rs, "RS", 2))
-          continue;
-
-        // Parse "RS###[-...-###]" string...
-        for (rsptr = rs + 2, j = 0; j < PAPPL_MAX_RESOLUTION && rsptr && *rsptr; j ++)
-        {
-          if (*rsptr == '-')
-            rsptr ++;
-
-          data->x_resolution[j] = data->y_resolution[j] = (int)strtol(rsptr, (char **)&rsptr, 10);
-          data->num_resolution ++;
-        }
-        break;
-      }
-    }
-    else if ((attr = ippFindAttribute(response, "printer-resolution-supported", IPP_TAG_RESOLUTION)) != NULL)
-    {
-      ipp_res_t units;			// Units
-
-      if ((count = ippGetCount(attr)) > PAPPL_MAX_RESOLUTION)
-      {
-        i                    = count - PAPPL_MAX_RESOLUTION + 1;
-        data->num_resolution = PAPPL_MAX_RESOLUTION;
-      }
-      else
-      {
-        i                    = 0;
-        data->num_resolution = count;
-      }
-
-      for (j = 0; i < count; i ++, j ++)
-        data->x_resolution[j] = ippGetResolution(attr, i, data->y_resolution + j, &units);
-    }
-    else
-    {
-      // Default resolution of 300dpi
-      data->num_resolution  = 1;
-      data->x_resolution[0] = 300;
-      data->y_resolution[0] = 300;
-    }
-
-    data->x_default = data->x_resolution[(data->num_resolution + 1) / 2];
-    data->y_default = data->y_resolution[(data->num_resolution + 1) / 2];
-
-    // Media
-    if ((attr = ippFindAttribute(response, "media-supported", IPP_TAG_KEYWORD)) == NULL)
-      attr = ippFindAttribute(response, "media-supported", IPP_TAG_NAME);
-
-    if (attr)
-    {
-      // Use printer media list
-      if ((count = ippGetCount(attr)) > PAPPL_MAX_MEDIA)
-        count = PAPPL_MAX_MEDIA;
-
-      data->num_media = count;
-      for (i = 0; i < count; i ++)
-        data->media[i] = get_string(ippGetString(attr, i, NULL));
-    }
-    else
-    {
-      // Use default media list
-      data->num_media = sizeof(pclps_media) / sizeof(pclps_media[0]);
-      memcpy(data->media, pclps_media, sizeof(pclps_media));
-    }
-
-    if ((attr = ippFindAttribute(response, "media-left-margin-supported", IPP_TAG_INTEGER)) != NULL)
-      data->left_right = ippGetInteger(attr, ippGetCount(attr) - 1);
-    else
-      data->left_right = 423;		// Default 1/6" left/right margins
-
-    data->borderless = ippContainsInteger(attr, 0);
-
-    if ((attr = ippFindAttribute(response, "media-top-margin-supported", IPP_TAG_INTEGER)) != NULL)
-      data->bottom_top = ippGetInteger(attr, ippGetCount(attr) - 1);
-    else
-      data->bottom_top = 423;		// Default 1/6" top/bottom margins
-
-    data->borderless &= ippContainsInteger(attr, 0);
-
-    if ((attr = ippFindAttribute(response, "media-source-supported", IPP_TAG_KEYWORD)) == NULL)
-      attr = ippFindAttribute(response, "media-source-supported", IPP_TAG_NAME);
-
-    if (attr)
-    {
-      // Use printer media source list
-      if ((count = ippGetCount(attr)) > PAPPL_MAX_SOURCE)
-        count = PAPPL_MAX_SOURCE;
-
-      data->num_source = count;
-      for (i = 0; i < count; i ++)
-        data->source[i] = get_string(ippGetString(attr, i, NULL));
-    }
-    else
-    {
-      // Use default media source list
-      data->num_source = 1;
-      data->source[0]  = "auto";
-    }
-
-    if ((attr = ippFindAttribute(response, "media-type-supported", IPP_TAG_KEYWORD)) == NULL)
-      attr = ippFindAttribute(response, "media-type-supported", IPP_TAG_NAME);
-
-    if (attr)
-    {
-      // Use printer media type list
-      if ((count = ippGetCount(attr)) > PAPPL_MAX_TYPE)
-        count = PAPPL_MAX_TYPE;
-
-      data->num_type = count;
-      for (i = 0; i < count; i ++)
-        data->type[i] = get_string(ippGetString(attr, i, NULL));
-    }
-    else
-    {
-      // Use default media type list
-      data->num_type = 1;
-      data->type[0]  = "auto";
-    }
-
-    if ((attr = ippFindAttribute(response, "media-col-default", IPP_TAG_BEGIN_COLLECTION)) != NULL)
-    {
-      ipp_t		*col;		// Collection value
-
-      col = ippGetCollection(attr, 0);
-
-      data->media_default.size_width    = ippGetInteger(ippFindAttribute(col, "media-size/x-dimension", IPP_TAG_INTEGER), 0);
-      data->media_default.size_length   = ippGetInteger(ippFindAttribute(col, "media-size/x-dimension", IPP_TAG_INTEGER), 0);
-      data->media_default.bottom_margin = ippGetInteger(ippFindAttribute(col, "media-bottom-margin", IPP_TAG_INTEGER), 0);
-      data->media_default.left_margin   = ippGetInteger(ippFindAttribute(col, "media-left-margin", IPP_TAG_INTEGER), 0);
-      data->media_default.right_margin  = ippGetInteger(ippFindAttribute(col, "media-right-margin", IPP_TAG_INTEGER), 0);
-      data->media_default.top_margin    = ippGetInteger(ippFindAttribute(col, "media-top-margin", IPP_TAG_INTEGER), 0);
-
-      if ((pwg = pwgMediaForSize(data->media_default.size_width, data->media_default.size_length)) != NULL)
-        cupsCopyString(data->media_default.size_name, pwg->pwg, sizeof(data->media_default.size_name));
-      else
-        pwgFormatSizeName(data->media_default.size_name, sizeof(data->media_default.size_name), "custom", /*name*/NULL, data->media_default.size_width, data->media_default.size_length, /*units*/NULL);
-
-      if ((keyword = ippGetString(ippFindAttribute(col, "media-source", IPP_TAG_KEYWORD), 0, NULL)) != NULL)
-        cupsCopyString(data->media_default.source, keyword, sizeof(data->media_default.source));
-
-      if ((keyword = ippGetString(ippFindAttribute(col, "media-type", IPP_TAG_KEYWORD), 0, NULL)) != NULL)
-        cupsCopyString(data->media_default.type, keyword, sizeof(data->media_default.type));
-    }
-    else
-    {
-      if ((attr = ippFindAttribute(response, "media-default", IPP_TAG_KEYWORD)) == NULL)
-        attr = ippFindAttribute(response, "media-default", IPP_TAG_NAME);
-
-      if ((keyword = ippGetString(attr, 0, NULL)) == NULL)
-        keyword = "iso_a4_210x297mm";
-
-      cupsCopyString(data->media_default.size_name, keyword, sizeof(data->media_default.size_name));
-
-      if ((pwg = pwgMediaForPWG(keyword)) != NULL)
-      {
-        data->media_default.size_width  = pwg->width;
-        data->media_default.size_length = pwg->length;
-      }
-      else
-      {
-        // Default to ISO A4 dimensions
-        data->media_default.size_width  = 21000;
-        data->media_default.size_length = 29700;
-      }
-
-      data->media_default.bottom_margin = data->bottom_top;
-      data->media_default.left_margin   = data->left_right;
-      data->media_default.right_margin  = data->left_right;
-      data->media_default.top_margin    = data->bottom_top;
-
-      cupsCopyString(data->media_default.source, data->source[0], sizeof(data->media_default.source));
-      cupsCopyString(data->media_default.type, data->type[0], sizeof(data->media_default.type));
-    }
-
-    // Duplex
-    if ((attr = ippFindAttribute(response, "sides-supported", IPP_TAG_KEYWORD)) != NULL && ippGetCount(attr) > 1)
-    {
-      // 1- or 2-sided printing
-      data->sides_supported = PAPPL_SIDES_ONE_SIDED | PAPPL_SIDES_TWO_SIDED_LONG_EDGE | PAPPL_SIDES_TWO_SIDED_SHORT_EDGE;
-      data->sides_default   = PAPPL_SIDES_TWO_SIDED_LONG_EDGE;
-    }
-    else
-    {
-      // 1-sided printing only
-      data->sides_supported = PAPPL_SIDES_ONE_SIDED;
-      data->sides_default   = PAPPL_SIDES_ONE_SIDED;
-    }
+    // Get the printer capabilities from the cache or the printer...
+    char	filename[1024];		// Cache filename
+    ipp_t	*response;		// Printer attributes
 
-    // Finishings
-    if ((attr = ippFindAttribute(response, "finishings-supported", IPP_TAG_ENUM)) != NULL)
+    if ((response = eve_cache_read(device_uri, filename, sizeof(filename))) != NULL)
     {
-      // Update to support all finishings in PAPPL 2.x...
-      if (ippContainsInteger(attr, IPP_FINISHINGS_PUNCH))
-        data->finishings_supported |= PAPPL_FINISHINGS_PUNCH;
-      if (ippContainsInteger(attr, IPP_FINISHINGS_STAPLE))
-        data->finishings_supported |= PAPPL_FINISHINGS_STAPLE;
-      if (ippContainsInteger(attr, IPP_FINISHINGS_TRIM))
-        data->finishings_supported |= PAPPL_FINISHINGS_TRIM;
-    }
+      // Use the cached capabilities now and check for changes in the
+      // background...
+      papplLog(system, PAPPL_LOGLEVEL_DEBUG, "Using cached capabilities for IPP printer '%s'.", device_uri);
 
-    // Color modes
-    if ((attr = ippFindAttribute(response, "print-color-mode-supported", IPP_TAG_KEYWORD)) != NULL)
-    {
-      data->color_supported = 0;
-      if (ippContainsString(attr, "auto"))
-        data->color_supported |= PAPPL_COLOR_MODE_AUTO;
-      if (ippContainsString(attr, "auto-monochrome"))
-        data->color_supported |= PAPPL_COLOR_MODE_AUTO_MONOCHROME;
-      if (ippContainsString(attr, "bi-level"))
-        data->color_supported |= PAPPL_COLOR_MODE_BI_LEVEL;
-      if (ippContainsString(attr, "color"))
-        data->color_supported |= PAPPL_COLOR_MODE_COLOR;
-      if (ippContainsString(attr, "monochrome"))
-        data->color_supported |= PAPPL_COLOR_MODE_MONOCHROME;
-      if (ippContainsString(attr, "process-monochrome"))
-        data->color_supported |= PAPPL_COLOR_MODE_PROCESS_MONOCHROME;
-    }
-    else if (ippGetBoolean(ippFindAttribute(response, "color-supported", IPP_TAG_BOOLEAN), 0))
-    {
-      data->color_supported = PAPPL_COLOR_MODE_AUTO | PAPPL_COLOR_MODE_COLOR | PAPPL_COLOR_MODE_MONOCHROME;
+      eve_probe(system, device_uri, filename, ippGetInteger(ippFindAttribute(response, "printer-config-change-time", IPP_TAG_INTEGER), 0), /*timeout*/0.0, /*response*/NULL);
     }
-    else
+    else if (eve_probe(system, device_uri, filename, /*config_change_time*/0, EVE_PROBE_WAIT, &response))
     {
-      data->color_supported = PAPPL_COLOR_MODE_MONOCHROME;
-    }
-
-    if (data->color_supported & PAPPL_COLOR_MODE_COLOR)
-      data->color_default = PAPPL_COLOR_MODE_AUTO;
-    else
-      data->color_default = PAPPL_COLOR_MODE_MONOCHROME;
+      // The printer answered quickly...
+      if (!response)
+        return (false);
 
-    if ((attr = ippFindAttribute(response, "pwg-raster-document-type-supported", IPP_TAG_KEYWORD)) != NULL)
-    {
-      data->raster_types = 0;
-      if (ippContainsString(attr, "adobe-rgb_8"))
-        data->raster_types |= PAPPL_RASTER_TYPE_ADOBE_RGB_8;
-      if (ippContainsString(attr, "adobe-rgb_16"))
-        data->raster_types |= PAPPL_RASTER_TYPE_ADOBE_RGB_16;
-      if (ippContainsString(attr, "black_1"))
-        data->raster_types |= PAPPL_RASTER_TYPE_BLACK_1;
-      if (ippContainsString(attr, "black_8"))
-        data->raster_types |= PAPPL_RASTER_TYPE_BLACK_8;
-      if (ippContainsString(attr, "black_16"))
-        data->raster_types |= PAPPL_RASTER_TYPE_BLACK_16;
-      if (ippContainsString(attr, "cmyk_8"))
-        data->raster_types |= PAPPL_RASTER_TYPE_CMYK_8;
-      if (ippContainsString(attr, "cmyk_16"))
-        data->raster_types |= PAPPL_RASTER_TYPE_CMYK_16;
-      if (ippContainsString(attr, "rgb_8"))
-        data->raster_types |= PAPPL_RASTER_TYPE_RGB_8;
-      if (ippContainsString(attr, "rgb_16"))
-        data->raster_types |= PAPPL_RASTER_TYPE_RGB_16;
-      if (ippContainsString(attr, "sgray_8"))
-        data->raster_types |= PAPPL_RASTER_TYPE_SGRAY_8;
-      if (ippContainsString(attr, "sgray_16"))
-        data->raster_types |= PAPPL_RASTER_TYPE_SGRAY_16;
-      if (ippContainsString(attr, "srgb_8"))
-        data->raster_types |= PAPPL_RASTER_TYPE_SRGB_8;
-      if (ippContainsString(attr, "srgb_16"))
-        data->raster_types |= PAPPL_RASTER_TYPE_SRGB_16;
-    }
-    else if ((attr = ippFindAttribute(response, "urf-supported", IPP_TAG_KEYWORD)) != NULL)
-    {
-      data->raster_types = 0;
-      if (ippContainsString(attr, "W8"))
-        data->raster_types |= PAPPL_RASTER_TYPE_SGRAY_8;
-      if (ippContainsString(attr, "SRGB24"))
-        data->raster_types |= PAPPL_RASTER_TYPE_SRGB_8;
-      if (ippContainsString(attr, "ADOBERGB24"))
-        data->raster_types |= PAPPL_RASTER_TYPE_ADOBE_RGB_8;
-      if (ippContainsString(attr, "ADOBERGB48"))
-        data->raster_types |= PAPPL_RASTER_TYPE_ADOBE_RGB_16;
-    }
-    else if (ippGetBoolean(ippFindAttribute(response, "color-supported", IPP_TAG_BOOLEAN), 0))
-    {
-      data->raster_types = PAPPL_RASTER_TYPE_SGRAY_8 | PAPPL_RASTER_TYPE_SRGB_8;
+      eve_cache_write(filename, response);
     }
     else
     {
-      data->raster_types = PAPPL_RASTER_TYPE_SGRAY_8;
-    }
+      // Use generic capabilities until the printer answers...
+      papplLog(system, PAPPL_LOGLEVEL_WARN, "IPP printer '%s' has not responded yet, using generic capabilities.", device_uri);
 
-    // Kind
-    if ((attr = ippFindAttribute(response, "printer-kind", IPP_TAG_KEYWORD)) != NULL)
-    {
-      data->kind = 0;
-      if (ippContainsString(attr, "disc"))
-        data->kind |= PAPPL_KIND_DISC;
-      if (ippContainsString(attr, "document"))
-        data->kind |= PAPPL_KIND_DOCUMENT;
-      if (ippContainsString(attr, "envelope"))
-        data->kind |= PAPPL_KIND_ENVELOPE;
-      if (ippContainsString(attr, "label"))
-        data->kind |= PAPPL_KIND_LABEL;
-      if (ippContainsString(attr, "large-format"))
-        data->kind |= PAPPL_KIND_LARGE_FORMAT;
-      if (ippContainsString(attr, "photo"))
-        data->kind |= PAPPL_KIND_PHOTO;
-      if (ippContainsString(attr, "postcard"))
-        data->kind |= PAPPL_KIND_POSTCARD;
-      if (ippContainsString(attr, "receipt"))
-        data->kind |= PAPPL_KIND_RECEIPT;
-      if (ippContainsString(attr, "roll"))
-        data->kind |= PAPPL_KIND_ROLL;
-    }
-    else
-    {
-      data->kind = PAPPL_KIND_DOCUMENT;
+      response = eve_default_attributes();
     }
 
-    // Supplies
-    data->has_supplies = ippFindAttribute(response, "marker-levels", IPP_TAG_INTEGER) != NULL || ippFindAttribute(response, "printer-supply", IPP_TAG_STRING) != NULL;
-
-    // Default icons
-    // TODO: Get real icons
-    data->icons[0].data    = everywhere_sm_png;
-    data->icons[0].datalen = sizeof(everywhere_sm_png);
-
-    data->icons[1].data    = everywhere_md_png;
-    data->icons[1].datalen = sizeof(everywhere_md_png);
-
-    data->icons[2].data    = everywhere_lg_png;
-    data->icons[2].datalen = sizeof(everywhere_lg_png);
+    // Copy over capabilities...
+    eve_copy_capabilities(data, response);
 
-    // Cleanup...
     ippDelete(response);
-    httpClose(http);
   }
   else
   {
@@ -768,22 +549,86 @@ LocalDriverCallback(
 
 
 //
-// 'get_string()' - Get or allocate a string in the pool.
+// 'LocalDriverShutdown()' - Stop probing printers.
+//
+// This wakes up any probe threads and waits for them to finish, so it must be
+// called before the system is deleted.
+//
+
+void
+LocalDriverShutdown(void)
+{
+  cupsMutexLock(&eve_mutex);
+  eve_shutdown = true;
+  cupsCondBroadcast(&eve_cond);
+  cupsMutexUnlock(&eve_mutex);
+
+  eve_threads_join(/*all*/true);
+}
+
+
+//
+// 'add_string()' - Find or add a string in the pool.
+//
+// Slots are claimed with a compare-and-swap, and strings are never removed, so
+// a slot that is not `NULL` never changes.  Strings that don't fit in the pool
+// go in a sorted array protected by a mutex.
 //
 
 static const char *			// O - String from pool
-get_string(const char *s)		// I - String to save
+add_string(const char *s,		// I - String to find or add
+           bool       copy)		// I - Copy the string when adding?
 {
-  const char	*ret;			// Return value
+  size_t	i,			// Looping var
+		hash;			// Hash of string
+  const char	*sptr,			// Pointer into string
+		*current,		// Current string in slot
+		*ret = NULL;		// Return value
+  char		*scopy = NULL;		// Copy of string
+
+
+  // FNV-1a hash of the string...
+  for (hash = 2166136261U, sptr = s; *sptr; sptr ++)
+    hash = (hash ^ (unsigned char)*sptr) * 16777619U;
+
+  for (i = 0; i < STRING_POOL; i ++, hash ++)
+  {
+    _Atomic(const char *) *slot = string_pool + (hash & (STRING_POOL - 1));
+					// Current slot
+
+    if ((current = atomic_load_explicit(slot, memory_order_acquire)) == NULL)
+    {
+      // Empty slot, try to claim it...
+      if (!copy)
+        ret = s;
+      else if (!scopy && (scopy = strdup(s)) == NULL)
+        return (NULL);
+      else
+        ret = scopy;
+
+      if (atomic_compare_exchange_strong_explicit(slot, &current, ret, memory_order_acq_rel, memory_order_acquire))
+        return (ret);
+
+      // Another thread claimed the slot first, "current" is its string...
+    }
+
+    if (!strcmp(current, s))
+    {
+      free(scopy);
+      return (current);
+    }
+  }
 
+  // Pool is full...
+  free(scopy);
 
   cupsMutexLock(&string_mutex);
-  if (!string_pool)
-    string_pool = cupsArrayNewStrings(NULL, '\0');
-  if ((ret = cupsArrayFind(string_pool, (void *)s)) == NULL)
+  if (!string_overflow)
+    string_overflow = cupsArrayNewStrings(NULL, '\0');
+  if ((ret = cupsArrayFind(string_overflow, (void *)s)) == NULL)
   {
-    cupsArrayAdd(string_pool, (void *)s);
-    ret = cupsArrayFind(string_pool, (void *)s);
+    cupsArrayAdd(string_overflow, (void *)s);
+    ret = cupsArrayFind(string_overflow, (void *)s);
   }
   cupsMutexUnlock(&string_mutex);
 
@@ -792,377 +637,1400 @@ get_string(const char *s)		// I - String to save
 
 
 //
-// 'pcl_compress_data()' - Compress a line of graphics.
+// 'eve_cache_probe()' - Probe a printer for its capabilities.
+//
+// When there is a cached "printer-config-change-time" value, the printer is
+// first asked for its current value and the full capabilities are only
+// fetched when it differs.  The capabilities are returned in "cache", or
+// `NULL` if they are unchanged or the printer could not be queried.  At most
+// EVE_MAX_PROBES printers are probed at the same time.
 //
 
 static void
-pcl_compress_data(
-    pcl_data_t          *pcl,		// I - Job data
-    pappl_device_t      *device,	// I - Device
-    unsigned            y,		// I - Line number
-    const unsigned char *line,		// I - Data to compress
-    unsigned            length)		// I - Number of bytes
+eve_cache_probe(eve_cache_t *cache)	// I - Revalidation data
 {
-  const unsigned char	*line_ptr,	// Current byte pointer
-			*line_end,	// End-of-line byte pointer
-			*start;		// Start of compression sequence
-  unsigned char		*comp_ptr;	// Pointer into compression buffer
-  unsigned		count;		// Count of bytes for output
-  int			comp;		// Current compression type
+  ipp_t		*response;		// Printer attributes
+  int		config_change_time;	// Current printer-config-change-time value
+  bool		update = true;		// Get the full capabilities?
+  double	start;			// Start time
 
 
-  // Try doing TIFF PackBits compression...
-  line_ptr = line;
-  line_end = line + length;
-  comp_ptr = pcl->comp_buffer;
+  // Wait for a free probe slot...
+  cupsMutexLock(&eve_mutex);
+  while (eve_probes >= EVE_MAX_PROBES && !eve_shutdown)
+    cupsCondWait(&eve_cond, &eve_mutex, 0.0);
 
-  while (line_ptr < line_end)
+  if (eve_shutdown)
   {
-    if ((line_ptr + 1) >= line_end)
-    {
-      // Single byte on the end...
-      *comp_ptr++ = 0x00;
-      *comp_ptr++ = *line_ptr++;
-    }
-    else if (line_ptr[0] == line_ptr[1])
-    {
-      // Repeated sequence...
-      line_ptr ++;
-      count = 2;
+    cupsMutexUnlock(&eve_mutex);
+    return;
+  }
 
-      while (line_ptr < (line_end - 1) && line_ptr[0] == line_ptr[1] && count < 128)
-      {
-	line_ptr ++;
-	count ++;
-      }
+  eve_probes ++;
+  cupsMutexUnlock(&eve_mutex);
+
+  start = cupsGetClock();
 
-      *comp_ptr++ = (unsigned char)(257 - count);
-      *comp_ptr++ = *line_ptr++;
+  if (cache->config_change_time > 0)
+  {
+    // Get the current configuration change time...
+    if (!eve_get_attributes(cache->system, cache->device_uri, "printer-config-change-time", &response) || ippGetStatusCode(response) > IPP_STATUS_OK_EVENTS_COMPLETE)
+    {
+      update = false;
     }
-    else
+    else if ((config_change_time = ippGetInteger(ippFindAttribute(response, "printer-config-change-time", IPP_TAG_INTEGER), 0)) > 0 && config_change_time == cache->config_change_time)
     {
-      // Non-repeated sequence...
-      start    = line_ptr;
-      line_ptr ++;
-      count    = 1;
-
-      while (line_ptr < (line_end - 1) && line_ptr[0] != line_ptr[1] && count < 128)
-      {
-	line_ptr ++;
-	count ++;
-      }
-
-      *comp_ptr++ = (unsigned char)(count - 1);
-
-      memcpy(comp_ptr, start, count);
-      comp_ptr += count;
+      papplLog(cache->system, PAPPL_LOGLEVEL_DEBUG, "Cached capabilities for IPP printer '%s' are up-to-date.", cache->device_uri);
+      update = false;
     }
-  }
 
-  if ((unsigned)(comp_ptr - pcl->comp_buffer) > length)
-  {
-    // Don't try compressing...
-    comp     = 0;
-    line_ptr = pcl->comp_buffer;
-    line_end = pcl->comp_buffer + length;
-  }
-  else
-  {
-    // Use PackBits compression...
-    comp     = 2;
-    line_ptr = pcl->comp_buffer;
-    line_end = comp_ptr;
+    ippDelete(response);
   }
 
-  // Set compression mode as needed...
-  if (pcl->compression != comp)
+  if (update && eve_get_attributes(cache->system, cache->device_uri, /*requested*/NULL, &cache->response) && ippGetStatusCode(cache->response) > IPP_STATUS_OK_EVENTS_COMPLETE)
   {
-    // Set compression
-    pcl->compression = comp;
-    papplDevicePrintf(device, "\033*b%uM", pcl->compression);
+    ippDelete(cache->response);
+    cache->response = NULL;
   }
 
-  // Set the length of the data and write a raster plane...
-  papplDevicePrintf(device, "\033*b%dW", (int)(line_end - line_ptr));
-  papplDeviceWrite(device, line_ptr, (size_t)(line_end - line_ptr));
+  LocalMetricsAdd(LOCAL_METRIC_PROBE, 1, cupsGetClock() - start);
+
+  // Release the probe slot...
+  cupsMutexLock(&eve_mutex);
+  eve_probes --;
+  cupsCondBroadcast(&eve_cond);
+  cupsMutexUnlock(&eve_mutex);
 }
 
 
 //
-// 'pcl_rendjob()' - End a job.
+// 'eve_cache_read()' - Read cached printer capabilities.
+//
+// The cache file for a printer is "SPOOLDIR/everywhere-HASH.ipp", where HASH
+// is the SHA-256 hash of the device URI.  The cache filename is returned even
+// when there is no cached data.
 //
 
-static bool				// O - `true` on success, `false` on failure
-pcl_rendjob(
-    pappl_job_t        *job,		// I - Job
-    pappl_pr_options_t *options,	// I - Options
-    pappl_device_t     *device)		// I - Device
+static ipp_t *				// O - Cached attributes or `NULL` if none
+eve_cache_read(
+    const char *device_uri,		// I - Device URI
+    char       *filename,		// I - Cache filename buffer
+    size_t     filesize)		// I - Size of cache filename buffer
 {
-  pcl_data_t	*pcl = (pcl_data_t *)papplJobGetData(job);
-					// Job data
+  unsigned char	hash[32];		// SHA-256 hash of URI
+  char		hashstr[65];		// Hash as a hex string
+  cups_file_t	*fp;			// Cache file
+  ipp_t		*response;		// Cached attributes
+  ipp_state_t	state;			// IPP read state
 
 
-  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Ending job...");
+  cupsHashData("sha2-256", device_uri, strlen(device_uri), hash, sizeof(hash));
+  snprintf(filename, filesize, "%s/everywhere-%s.ipp", LocalSpoolDir, cupsHashString(hash, sizeof(hash), hashstr, sizeof(hashstr)));
 
-  (void)options;
+  if ((fp = cupsFileOpen(filename, "r")) == NULL)
+    return (NULL);
 
-  papplDevicePuts(device, "\033E");
+  response = ippNew();
 
-  free(pcl);
-  papplJobSetData(job, NULL);
+  while ((state = ippReadIO(fp, (ipp_io_cb_t)eve_cache_read_cb, /*blocking*/true, /*parent*/NULL, response)) != IPP_STATE_DATA)
+  {
+    if (state == IPP_STATE_ERROR)
+    {
+      ippDelete(response);
+      response = NULL;
+      break;
+    }
+  }
 
-  pclps_update_status(papplJobGetPrinter(job), device);
+  cupsFileClose(fp);
 
-  return (true);
+  return (response);
 }
 
 
 //
-// 'pcl_rendpage()' - End a page.
+// 'eve_cache_read_cb()' - Read data from a cache file.
 //
 
-static bool				// O - `true` on success, `false` on failure
-pcl_rendpage(
-    pappl_job_t        *job,		// I - Job
-    pappl_pr_options_t *options,	// I - Job options
-    pappl_device_t     *device,		// I - Device
-    unsigned           page)		// I - Page number
+static ssize_t				// O - Number of bytes read
+eve_cache_read_cb(cups_file_t *fp,	// I - Cache file
+                  ipp_uchar_t *buffer,	// I - Read buffer
+                  size_t      bytes)	// I - Number of bytes to read
 {
-  pcl_data_t	*pcl = (pcl_data_t *)papplJobGetData(job);
-					// Job data
+  return (cupsFileRead(fp, (char *)buffer, bytes));
+}
 
 
-  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Ending page %u...", page);
+//
+// 'eve_cache_update()' - Probe a printer and update its cached capabilities.
+//
+// If the driver callback is still waiting for the response it is handed over
+// in "cache", otherwise the cache file and any printers using the device URI
+// are updated.  A printer that was added with generic capabilities is probed
+// again, with increasing delays, until it answers or EVE_PROBE_RETRIES
+// retries have failed, and its capabilities are applied once PAPPL has added
+// it to the system.
+//
 
-  // Eject the current page...
-  papplDevicePuts(device, "\033*r0B");// End GFX
+static void *				// O - Thread exit status
+eve_cache_update(eve_cache_t *cache)	// I - Revalidation data
+{
+  int		retry;			// Current retry
+  eve_thread_t	*thread = cache->thread;// Probe thread
 
-  if (!(options->header.Duplex && (page & 1)))
-    papplDevicePuts(device, "\014");  // Eject current page
 
-  papplDeviceFlush(device);
+  eve_cache_probe(cache);
 
-  // Free memory...
-  free(pcl->line_buffer);
-  free(pcl->comp_buffer);
+  // Hand the response to a waiting driver callback...
+  cupsMutexLock(&eve_mutex);
 
-  return (true);
-}
+  cache->done = true;
+
+  cupsCondBroadcast(&eve_cond);
+
+  if (cache->waiting)
+  {
+    thread->finished = true;
+    cupsMutexUnlock(&eve_mutex);
+    return (NULL);
+  }
+
+  cupsMutexUnlock(&eve_mutex);
+
+  for (retry = 1; !cache->response && cache->generic && retry <= EVE_PROBE_RETRIES; retry ++)
+  {
+    papplLog(cache->system, PAPPL_LOGLEVEL_ERROR, "Unable to get capabilities for IPP printer '%s', retrying in %d seconds.", cache->device_uri, retry * EVE_PROBE_RETRY);
+
+    if (!eve_wait(retry * EVE_PROBE_RETRY))
+      break;
+
+    eve_cache_probe(cache);
+  }
+
+  if (cache->response && eve_wait(0.0))
+  {
+    // Update the cache and any printers using it...
+    papplLog(cache->system, PAPPL_LOGLEVEL_INFO, "Updating capabilities for IPP printer '%s'.", cache->device_uri);
+
+    eve_cache_write(cache->filename, cache->response);
+    papplSystemIteratePrinters(cache->system, (pappl_printer_cb_t)eve_cache_update_printer, cache);
+
+    // A new printer is only added to the system after the driver callback
+    // returns, so keep the response until it shows up...
+    for (retry = 0; !cache->updated && cache->generic && retry < EVE_APPLY_WAIT && eve_wait(1.0); retry ++)
+      papplSystemIteratePrinters(cache->system, (pappl_printer_cb_t)eve_cache_update_printer, cache);
+
+    if (!cache->updated && cache->generic && eve_wait(0.0))
+      papplLog(cache->system, PAPPL_LOGLEVEL_WARN, "No printer is using IPP printer '%s', capabilities saved for later.", cache->device_uri);
+  }
+  else if (!cache->response && cache->generic && eve_wait(0.0))
+  {
+    papplLog(cache->system, PAPPL_LOGLEVEL_ERROR, "Unable to get capabilities for IPP printer '%s', using generic capabilities.", cache->device_uri);
+  }
+
+  ippDelete(cache->response);
+  free(cache);
+
+  cupsMutexLock(&eve_mutex);
+  thread->finished = true;
+  cupsMutexUnlock(&eve_mutex);
+
+  return (NULL);
+}
+
+
+//
+// 'eve_cache_update_printer()' - Update the capabilities of a printer.
+//
+
+static void
+eve_cache_update_printer(
+    pappl_printer_t *printer,		// I - Printer
+    eve_cache_t     *cache)		// I - Revalidation data
+{
+  pappl_pr_driver_data_t data;		// Printer driver data
+
+
+  if (strcmp(papplPrinterGetDriverName(printer), "everywhere") || strcmp(papplPrinterGetDeviceURI(printer), cache->device_uri))
+    return;
+
+  papplPrinterGetDriverData(printer, &data);
+  eve_copy_capabilities(&data, cache->response);
+  papplPrinterSetDriverData(printer, &data, /*attrs*/NULL);
+
+  cache->updated ++;
+}
+
+
+//
+// 'eve_cache_write()' - Write cached printer capabilities.
+//
+// The attributes are written to a temporary file that replaces the cache
+// file, so readers never see a partial file.
+//
+
+static void
+eve_cache_write(const char *filename,	// I - Cache filename
+                ipp_t      *response)	// I - Printer attributes
+{
+  char		tempfile[1024];		// Temporary filename
+  cups_file_t	*fp;			// Cache file
+  ipp_state_t	state;			// IPP write state
+
+
+  snprintf(tempfile, sizeof(tempfile), "%s.%d", filename, (int)getpid());
+
+  if ((fp = cupsFileOpen(tempfile, "w")) == NULL)
+    return;
+
+  ippSetState(response, IPP_STATE_IDLE);
+
+  while ((state = ippWriteIO(fp, (ipp_io_cb_t)eve_cache_write_cb, /*blocking*/true, /*parent*/NULL, response)) != IPP_STATE_DATA)
+  {
+    if (state == IPP_STATE_ERROR)
+      break;
+  }
+
+  if (cupsFileClose(fp) && state == IPP_STATE_DATA)
+    rename(tempfile, filename);
+  else
+    unlink(tempfile);
+}
+
+
+//
+// 'eve_cache_write_cb()' - Write data to a cache file.
+//
+
+static ssize_t				// O - Number of bytes written
+eve_cache_write_cb(cups_file_t *fp,	// I - Cache file
+                   ipp_uchar_t *buffer,	// I - Write buffer
+                   size_t      bytes)	// I - Number of bytes to write
+{
+  return (cupsFileWrite(fp, (const char *)buffer, bytes) ? (ssize_t)bytes : -1);
+}
+
+
+//
+// 'eve_copy_capabilities()' - Copy printer capabilities to the driver data.
+//
+// The driver data may already hold the capabilities from an earlier response,
+// so everything derived from the printer attributes is reset first.
+//
+
+static void
+eve_copy_capabilities(
+    pappl_pr_driver_data_t *data,	// I - Printer driver data
+    ipp_t                  *response)	// I - Printer attributes
+{
+  size_t		i, j;		// Looping vars
+  ipp_attribute_t	*attr;		// Supported/default attribute
+  size_t		count;		// Number of values
+  pwg_media_t		*pwg;		// Media info
+  const char		*keyword;	// Source/type
+
+
+  // Reset values that are added to below...
+  data->format               = NULL;
+  data->num_resolution       = 0;
+  data->finishings_supported = PAPPL_FINISHINGS_NONE;
+
+  memset(data->x_resolution, 0, sizeof(data->x_resolution));
+  memset(data->y_resolution, 0, sizeof(data->y_resolution));
+  memset(&data->media_default, 0, sizeof(data->media_default));
+
+  // Make and model name
+  if ((attr = ippFindAttribute(response, "printer-make-and-model", IPP_TAG_TEXT)) != NULL)
+    cupsCopyString(data->make_and_model, ippGetString(attr, 0, NULL), sizeof(data->make_and_model));
+  else
+    cupsCopyString(data->make_and_model, "Generic IPP Printer", sizeof(data->make_and_model));
+
+  // Native format
+  attr = ippFindAttribute(response, "document-format-supported", IPP_TAG_MIMETYPE);
+  if (ippContainsString(attr, "application/pdf"))
+    data->format = "application/pdf";
+  else if (ippContainsString(attr, "image/urf"))
+    data->format = "image/urf";
+  else if (ippContainsString(attr, "image/pwg-raster"))
+    data->format = "image/pwg-raster";
+
+  // pages-per-minute[-color]
+  data->ppm       = ippGetInteger(ippFindAttribute(response, "pages-per-minute", IPP_TAG_INTEGER), 0);
+  data->ppm_color = ippGetInteger(ippFindAttribute(response, "pages-per-minute-color", IPP_TAG_INTEGER), 0);
+
+  // Resolutions
+  if ((attr = ippFindAttribute(response, "pwg-raster-document-resolution-supported", IPP_TAG_RESOLUTION)) != NULL)
+  {
+    ipp_res_t units;			// Units
+
+    if ((count = ippGetCount(attr)) > PAPPL_MAX_RESOLUTION)
+    {
+      i                    = count - PAPPL_MAX_RESOLUTION + 1;
+      data->num_resolution = PAPPL_MAX_RESOLUTION;
+    }
+    else
+    {
+      i                    = 0;
+      data->num_resolution = count;
+    }
+
+    for (j = 0; i < count; i ++, j ++)
+      data->x_resolution[j] = ippGetResolution(attr, i, data->y_resolution + j, &units);
+  }
+  else if ((attr = ippFindAttribute(response, "urf-supported", IPP_TAG_KEYWORD)) != NULL)
+  {
+    const char	*rs,		// Raster resolution value
+			*rsptr;		// Pointer into value
+
+    for (i = 0, count = ippGetCount(attr); i < count; i ++)
+    {
+      // Look for a resolution (RS) keyword...
+      rs = ippGetString(attr, i, NULL);
+      if (strncmp(rs, "RS", 2))
+        continue;
+
+      // Parse "RS###[-...-###]" string...
+      for (rsptr = rs + 2, j = 0; j < PAPPL_MAX_RESOLUTION && rsptr && *rsptr; j ++)
+      {
+        if (*rsptr == '-')
+          rsptr ++;
+
+        data->x_resolution[j] = data->y_resolution[j] = (int)strtol(rsptr, (char **)&rsptr, 10);
+        data->num_resolution ++;
+      }
+      break;
+    }
+  }
+  else if ((attr = ippFindAttribute(response, "printer-resolution-supported", IPP_TAG_RESOLUTION)) != NULL)
+  {
+    ipp_res_t units;			// Units
+
+    if ((count = ippGetCount(attr)) > PAPPL_MAX_RESOLUTION)
+    {
+      i                    = count - PAPPL_MAX_RESOLUTION + 1;
+      data->num_resolution = PAPPL_MAX_RESOLUTION;
+    }
+    else
+    {
+      i                    = 0;
+      data->num_resolution = count;
+    }
+
+    for (j = 0; i < count; i ++, j ++)
+      data->x_resolution[j] = ippGetResolution(attr, i, data->y_resolution + j, &units);
+  }
+  else
+  {
+    // Default resolution of 300dpi
+    data->num_resolution  = 1;
+    data->x_resolution[0] = 300;
+    data->y_resolution[0] = 300;
+  }
+
+  if (data->num_resolution == 0)
+  {
+    // No usable resolutions, default to 300dpi
+    data->num_resolution  = 1;
+    data->x_resolution[0] = 300;
+    data->y_resolution[0] = 300;
+  }
+
+  if ((i = (data->num_resolution + 1) / 2) >= data->num_resolution)
+    i = data->num_resolution - 1;
+
+  data->x_default = data->x_resolution[i];
+  data->y_default = data->y_resolution[i];
+
+  // Media
+  if ((attr = ippFindAttribute(response, "media-supported", IPP_TAG_KEYWORD)) == NULL)
+    attr = ippFindAttribute(response, "media-supported", IPP_TAG_NAME);
+
+  if (attr)
+  {
+    // Use printer media list
+    if ((count = ippGetCount(attr)) > PAPPL_MAX_MEDIA)
+      count = PAPPL_MAX_MEDIA;
+
+    data->num_media = count;
+    for (i = 0; i < count; i ++)
+      data->media[i] = get_string(ippGetString(attr, i, NULL));
+  }
+  else
+  {
+    // Use default media list
+    data->num_media = sizeof(pclps_media) / sizeof(pclps_media[0]);
+    memcpy(data->media, pclps_media, sizeof(pclps_media));
+  }
+
+  if ((attr = ippFindAttribute(response, "media-left-margin-supported", IPP_TAG_INTEGER)) != NULL)
+    data->left_right = ippGetInteger(attr, ippGetCount(attr) - 1);
+  else
+    data->left_right = 423;		// Default 1/6" left/right margins
+
+  data->borderless = ippContainsInteger(attr, 0);
+
+  if ((attr = ippFindAttribute(response, "media-top-margin-supported", IPP_TAG_INTEGER)) != NULL)
+    data->bottom_top = ippGetInteger(attr, ippGetCount(attr) - 1);
+  else
+    data->bottom_top = 423;		// Default 1/6" top/bottom margins
+
+  data->borderless &= ippContainsInteger(attr, 0);
+
+  if ((attr = ippFindAttribute(response, "media-source-supported", IPP_TAG_KEYWORD)) == NULL)
+    attr = ippFindAttribute(response, "media-source-supported", IPP_TAG_NAME);
+
+  if (attr)
+  {
+    // Use printer media source list
+    if ((count = ippGetCount(attr)) > PAPPL_MAX_SOURCE)
+      count = PAPPL_MAX_SOURCE;
+
+    data->num_source = count;
+    for (i = 0; i < count; i ++)
+      data->source[i] = get_string(ippGetString(attr, i, NULL));
+  }
+  else
+  {
+    // Use default media source list
+    data->num_source = 1;
+    data->source[0]  = "auto";
+  }
+
+  if ((attr = ippFindAttribute(response, "media-type-supported", IPP_TAG_KEYWORD)) == NULL)
+    attr = ippFindAttribute(response, "media-type-supported", IPP_TAG_NAME);
+
+  if (attr)
+  {
+    // Use printer media type list
+    if ((count = ippGetCount(attr)) > PAPPL_MAX_TYPE)
+      count = PAPPL_MAX_TYPE;
+
+    data->num_type = count;
+    for (i = 0; i < count; i ++)
+      data->type[i] = get_string(ippGetString(attr, i, NULL));
+  }
+  else
+  {
+    // Use default media type list
+    data->num_type = 1;
+    data->type[0]  = "auto";
+  }
+
+  if ((attr = ippFindAttribute(response, "media-col-default", IPP_TAG_BEGIN_COLLECTION)) != NULL)
+  {
+    ipp_t		*col;		// Collection value
+
+    col = ippGetCollection(attr, 0);
+
+    data->media_default.size_width    = ippGetInteger(ippFindAttribute(col, "media-size/x-dimension", IPP_TAG_INTEGER), 0);
+    data->media_default.size_length   = ippGetInteger(ippFindAttribute(col, "media-size/x-dimension", IPP_TAG_INTEGER), 0);
+    data->media_default.bottom_margin = ippGetInteger(ippFindAttribute(col, "media-bottom-margin", IPP_TAG_INTEGER), 0);
+    data->media_default.left_margin   = ippGetInteger(ippFindAttribute(col, "media-left-margin", IPP_TAG_INTEGER), 0);
+    data->media_default.right_margin  = ippGetInteger(ippFindAttribute(col, "media-right-margin", IPP_TAG_INTEGER), 0);
+    data->media_default.top_margin    = ippGetInteger(ippFindAttribute(col, "media-top-margin", IPP_TAG_INTEGER), 0);
+
+    if ((pwg = pwgMediaForSize(data->media_default.size_width, data->media_default.size_length)) != NULL)
+      cupsCopyString(data->media_default.size_name, pwg->pwg, sizeof(data->media_default.size_name));
+    else
+      pwgFormatSizeName(data->media_default.size_name, sizeof(data->media_default.size_name), "custom", /*name*/NULL, data->media_default.size_width, data->media_default.size_length, /*units*/NULL);
+
+    if ((keyword = ippGetString(ippFindAttribute(col, "media-source", IPP_TAG_KEYWORD), 0, NULL)) != NULL)
+      cupsCopyString(data->media_default.source, keyword, sizeof(data->media_default.source));
+
+    if ((keyword = ippGetString(ippFindAttribute(col, "media-type", IPP_TAG_KEYWORD), 0, NULL)) != NULL)
+      cupsCopyString(data->media_default.type, keyword, sizeof(data->media_default.type));
+  }
+  else
+  {
+    if ((attr = ippFindAttribute(response, "media-default", IPP_TAG_KEYWORD)) == NULL)
+      attr = ippFindAttribute(response, "media-default", IPP_TAG_NAME);
+
+    if ((keyword = ippGetString(attr, 0, NULL)) == NULL)
+      keyword = "iso_a4_210x297mm";
+
+    cupsCopyString(data->media_default.size_name, keyword, sizeof(data->media_default.size_name));
+
+    if ((pwg = pwgMediaForPWG(keyword)) != NULL)
+    {
+      data->media_default.size_width  = pwg->width;
+      data->media_default.size_length = pwg->length;
+    }
+    else
+    {
+      // Default to ISO A4 dimensions
+      data->media_default.size_width  = 21000;
+      data->media_default.size_length = 29700;
+    }
+
+    data->media_default.bottom_margin = data->bottom_top;
+    data->media_default.left_margin   = data->left_right;
+    data->media_default.right_margin  = data->left_right;
+    data->media_default.top_margin    = data->bottom_top;
+
+    cupsCopyString(data->media_default.source, data->source[0], sizeof(data->media_default.source));
+    cupsCopyString(data->media_default.type, data->type[0], sizeof(data->media_default.type));
+  }
+
+  // Duplex
+  if ((attr = ippFindAttribute(response, "sides-supported", IPP_TAG_KEYWORD)) != NULL && ippGetCount(attr) > 1)
+  {
+    // 1- or 2-sided printing
+    data->sides_supported = PAPPL_SIDES_ONE_SIDED | PAPPL_SIDES_TWO_SIDED_LONG_EDGE | PAPPL_SIDES_TWO_SIDED_SHORT_EDGE;
+    data->sides_default   = PAPPL_SIDES_TWO_SIDED_LONG_EDGE;
+  }
+  else
+  {
+    // 1-sided printing only
+    data->sides_supported = PAPPL_SIDES_ONE_SIDED;
+    data->sides_default   = PAPPL_SIDES_ONE_SIDED;
+  }
+
+  // Finishings
+  if ((attr = ippFindAttribute(response, "finishings-supported", IPP_TAG_ENUM)) != NULL)
+  {
+    // Update to support all finishings in PAPPL 2.x...
+    if (ippContainsInteger(attr, IPP_FINISHINGS_PUNCH))
+      data->finishings_supported |= PAPPL_FINISHINGS_PUNCH;
+    if (ippContainsInteger(attr, IPP_FINISHINGS_STAPLE))
+      data->finishings_supported |= PAPPL_FINISHINGS_STAPLE;
+    if (ippContainsInteger(attr, IPP_FINISHINGS_TRIM))
+      data->finishings_supported |= PAPPL_FINISHINGS_TRIM;
+  }
+
+  // Color modes
+  if ((attr = ippFindAttribute(response, "print-color-mode-supported", IPP_TAG_KEYWORD)) != NULL)
+  {
+    data->color_supported = 0;
+    if (ippContainsString(attr, "auto"))
+      data->color_supported |= PAPPL_COLOR_MODE_AUTO;
+    if (ippContainsString(attr, "auto-monochrome"))
+      data->color_supported |= PAPPL_COLOR_MODE_AUTO_MONOCHROME;
+    if (ippContainsString(attr, "bi-level"))
+      data->color_supported |= PAPPL_COLOR_MODE_BI_LEVEL;
+    if (ippContainsString(attr, "color"))
+      data->color_supported |= PAPPL_COLOR_MODE_COLOR;
+    if (ippContainsString(attr, "monochrome"))
+      data->color_supported |= PAPPL_COLOR_MODE_MONOCHROME;
+    if (ippContainsString(attr, "process-monochrome"))
+      data->color_supported |= PAPPL_COLOR_MODE_PROCESS_MONOCHROME;
+  }
+  else if (ippGetBoolean(ippFindAttribute(response, "color-supported", IPP_TAG_BOOLEAN), 0))
+  {
+    data->color_supported = PAPPL_COLOR_MODE_AUTO | PAPPL_COLOR_MODE_COLOR | PAPPL_COLOR_MODE_MONOCHROME;
+  }
+  else
+  {
+    data->color_supported = PAPPL_COLOR_MODE_MONOCHROME;
+  }
+
+  if (data->color_supported & PAPPL_COLOR_MODE_COLOR)
+    data->color_default = PAPPL_COLOR_MODE_AUTO;
+  else
+    data->color_default = PAPPL_COLOR_MODE_MONOCHROME;
+
+  if ((attr = ippFindAttribute(response, "pwg-raster-document-type-supported", IPP_TAG_KEYWORD)) != NULL)
+  {
+    data->raster_types = 0;
+    if (ippContainsString(attr, "adobe-rgb_8"))
+      data->raster_types |= PAPPL_RASTER_TYPE_ADOBE_RGB_8;
+    if (ippContainsString(attr, "adobe-rgb_16"))
+      data->raster_types |= PAPPL_RASTER_TYPE_ADOBE_RGB_16;
+    if (ippContainsString(attr, "black_1"))
+      data->raster_types |= PAPPL_RASTER_TYPE_BLACK_1;
+    if (ippContainsString(attr, "black_8"))
+      data->raster_types |= PAPPL_RASTER_TYPE_BLACK_8;
+    if (ippContainsString(attr, "black_16"))
+      data->raster_types |= PAPPL_RASTER_TYPE_BLACK_16;
+    if (ippContainsString(attr, "cmyk_8"))
+      data->raster_types |= PAPPL_RASTER_TYPE_CMYK_8;
+    if (ippContainsString(attr, "cmyk_16"))
+      data->raster_types |= PAPPL_RASTER_TYPE_CMYK_16;
+    if (ippContainsString(attr, "rgb_8"))
+      data->raster_types |= PAPPL_RASTER_TYPE_RGB_8;
+    if (ippContainsString(attr, "rgb_16"))
+      data->raster_types |= PAPPL_RASTER_TYPE_RGB_16;
+    if (ippContainsString(attr, "sgray_8"))
+      data->raster_types |= PAPPL_RASTER_TYPE_SGRAY_8;
+    if (ippContainsString(attr, "sgray_16"))
+      data->raster_types |= PAPPL_RASTER_TYPE_SGRAY_16;
+    if (ippContainsString(attr, "srgb_8"))
+      data->raster_types |= PAPPL_RASTER_TYPE_SRGB_8;
+    if (ippContainsString(attr, "srgb_16"))
+      data->raster_types |= PAPPL_RASTER_TYPE_SRGB_16;
+  }
+  else if ((attr = ippFindAttribute(response, "urf-supported", IPP_TAG_KEYWORD)) != NULL)
+  {
+    data->raster_types = 0;
+    if (ippContainsString(attr, "W8"))
+      data->raster_types |= PAPPL_RASTER_TYPE_SGRAY_8;
+    if (ippContainsString(attr, "SRGB24"))
+      data->raster_types |= PAPPL_RASTER_TYPE_SRGB_8;
+    if (ippContainsString(attr, "ADOBERGB24"))
+      data->raster_types |= PAPPL_RASTER_TYPE_ADOBE_RGB_8;
+    if (ippContainsString(attr, "ADOBERGB48"))
+      data->raster_types |= PAPPL_RASTER_TYPE_ADOBE_RGB_16;
+  }
+  else if (ippGetBoolean(ippFindAttribute(response, "color-supported", IPP_TAG_BOOLEAN), 0))
+  {
+    data->raster_types = PAPPL_RASTER_TYPE_SGRAY_8 | PAPPL_RASTER_TYPE_SRGB_8;
+  }
+  else
+  {
+    data->raster_types = PAPPL_RASTER_TYPE_SGRAY_8;
+  }
+
+  // Kind
+  if ((attr = ippFindAttribute(response, "printer-kind", IPP_TAG_KEYWORD)) != NULL)
+  {
+    data->kind = 0;
+    if (ippContainsString(attr, "disc"))
+      data->kind |= PAPPL_KIND_DISC;
+    if (ippContainsString(attr, "document"))
+      data->kind |= PAPPL_KIND_DOCUMENT;
+    if (ippContainsString(attr, "envelope"))
+      data->kind |= PAPPL_KIND_ENVELOPE;
+    if (ippContainsString(attr, "label"))
+      data->kind |= PAPPL_KIND_LABEL;
+    if (ippContainsString(attr, "large-format"))
+      data->kind |= PAPPL_KIND_LARGE_FORMAT;
+    if (ippContainsString(attr, "photo"))
+      data->kind |= PAPPL_KIND_PHOTO;
+    if (ippContainsString(attr, "postcard"))
+      data->kind |= PAPPL_KIND_POSTCARD;
+    if (ippContainsString(attr, "receipt"))
+      data->kind |= PAPPL_KIND_RECEIPT;
+    if (ippContainsString(attr, "roll"))
+      data->kind |= PAPPL_KIND_ROLL;
+  }
+  else
+  {
+    data->kind = PAPPL_KIND_DOCUMENT;
+  }
+
+  // Supplies
+  data->has_supplies = ippFindAttribute(response, "marker-levels", IPP_TAG_INTEGER) != NULL || ippFindAttribute(response, "printer-supply", IPP_TAG_STRING) != NULL;
+
+  // Default icons
+  // TODO: Get real icons
+  data->icons[0].data    = everywhere_sm_png;
+  data->icons[0].datalen = sizeof(everywhere_sm_png);
+
+  data->icons[1].data    = everywhere_md_png;
+  data->icons[1].datalen = sizeof(everywhere_md_png);
+
+  data->icons[2].data    = everywhere_lg_png;
+  data->icons[2].datalen = sizeof(everywhere_lg_png);
+}
+
+
+//
+// 'eve_default_attributes()' - Make generic printer attributes.
+//
+// These are used when a new printer does not answer in time, and describe a
+// 300dpi grayscale PWG Raster printer with the generic PCL/PostScript media.
+//
+
+static ipp_t *				// O - Printer attributes
+eve_default_attributes(void)
+{
+  ipp_t		*response = ippNew();	// Printer attributes
+  static const char * const types[] =	// pwg-raster-document-type-supported values
+  {
+    "black_1",
+    "sgray_8"
+  };
+
+
+  ippAddString(response, IPP_TAG_PRINTER, IPP_TAG_MIMETYPE, "document-format-supported", NULL, "image/pwg-raster");
+  ippAddResolution(response, IPP_TAG_PRINTER, "pwg-raster-document-resolution-supported", IPP_RES_PER_INCH, 300, 300);
+  ippAddStrings(response, IPP_TAG_PRINTER, IPP_TAG_KEYWORD, "pwg-raster-document-type-supported", sizeof(types) / sizeof(types[0]), NULL, types);
+  ippAddStrings(response, IPP_TAG_PRINTER, IPP_TAG_KEYWORD, "media-supported", sizeof(pclps_media) / sizeof(pclps_media[0]), NULL, pclps_media);
+
+  return (response);
+}
+
+
+//
+// 'eve_get_attributes()' - Get printer attributes.
+//
+// "requested" is a single attribute name or `NULL` for all attributes.  The
+// response is `NULL` if the request fails after connecting to the printer.
+//
+
+static bool				// O - `true` on success, `false` if unable to connect
+eve_get_attributes(
+    pappl_system_t *system,		// I - System
+    const char     *device_uri,		// I - Device URI
+    const char     *requested,		// I - Requested attribute or `NULL`
+    ipp_t          **response)		// O - Printer attributes
+{
+  http_t		*http;		// HTTP connection
+  char			scheme[32],	// URI scheme
+			userpass[256],	// URI username:password (not used)
+			host[256],	// URI hostname
+			resource[256];	// URI resource path
+  int			port;		// URI port
+  http_encryption_t	encryption;	// Encryption to use
+  ipp_t			*request;	// IPP request
+
+
+  *response = NULL;
+
+  // Connect to the printer...
+  httpSeparateURI(HTTP_URI_CODING_ALL, device_uri, scheme, sizeof(scheme), userpass, sizeof(userpass), host, sizeof(host), &port, resource, sizeof(resource));
+  if (port == 443 || !strcmp(scheme, "ipps"))
+    encryption = HTTP_ENCRYPTION_ALWAYS;
+  else
+    encryption = HTTP_ENCRYPTION_IF_REQUESTED;
+
+  if ((http = httpConnect(host, port, /*addrlist*/NULL, AF_UNSPEC, encryption, /*blocking*/true, EVE_PROBE_TIMEOUT, /*cancel*/NULL)) == NULL)
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to connect to IPP printer '%s': %s", device_uri, cupsGetErrorString());
+    return (false);
+  }
+
+  // Don't let an unresponsive printer hold up the probe...
+  httpSetTimeout(http, EVE_PROBE_TIMEOUT / 1000.0, /*cb*/NULL, /*cb_data*/NULL);
+
+  // Get its capabilities...
+  request = ippNewRequest(IPP_OP_GET_PRINTER_ATTRIBUTES);
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, device_uri);
+  if (requested)
+    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "requested-attributes", NULL, requested);
+
+  *response = cupsDoRequest(http, request, resource);
+
+  httpClose(http);
+
+  return (true);
+}
+
+
+//
+// 'eve_probe()' - Start probing a printer for its capabilities.
+//
+// The probe runs in a background thread that is joined once it has finished
+// or by `LocalDriverShutdown()`.  When "timeout" is greater than 0, the
+// function waits up to "timeout" seconds for the printer to answer and
+// returns `true` with the printer attributes (or `NULL` if the printer could
+// not be queried) in "response".  Otherwise, or when the printer takes longer
+// to answer, `false` is returned and the probe updates the cache file and
+// printers itself when it finishes.
+//
+
+static bool				// O - `true` if the probe finished, `false` otherwise
+eve_probe(
+    pappl_system_t *system,		// I - System
+    const char     *device_uri,		// I - Device URI
+    const char     *filename,		// I - Cache filename
+    int            config_change_time,	// I - Cached printer-config-change-time value or `0`
+    double         timeout,		// I - Seconds to wait for the response
+    ipp_t          **response)		// O - Printer attributes or `NULL`
+{
+  eve_cache_t	*cache;			// Probe data
+  eve_thread_t	*thread;		// Probe thread
+  double	end;			// End time
+  bool		done;			// Did the probe finish?
+
+
+  if (response)
+    *response = NULL;
+
+  // Clean up after finished probes...
+  eve_threads_join(/*all*/false);
+
+  if ((cache = (eve_cache_t *)calloc(1, sizeof(eve_cache_t))) == NULL)
+    return (false);
+
+  if ((thread = (eve_thread_t *)calloc(1, sizeof(eve_thread_t))) == NULL)
+  {
+    free(cache);
+    return (false);
+  }
+
+  cache->system             = system;
+  cache->config_change_time = config_change_time;
+  cache->thread             = thread;
+  cache->waiting            = timeout > 0.0 && response != NULL;
+
+  cupsCopyString(cache->device_uri, device_uri, sizeof(cache->device_uri));
+  cupsCopyString(cache->filename, filename, sizeof(cache->filename));
+
+  cupsMutexLock(&eve_mutex);
+
+  if (eve_shutdown || (thread->thread = cupsThreadCreate((cups_thread_func_t)eve_cache_update, cache)) == CUPS_THREAD_INVALID)
+  {
+    cupsMutexUnlock(&eve_mutex);
+    free(thread);
+    free(cache);
+    return (false);
+  }
+
+  thread->next = eve_threads;
+  eve_threads  = thread;
+
+  cupsMutexUnlock(&eve_mutex);
+
+  if (timeout <= 0.0 || !response)
+    return (false);
+
+  // Wait for the probe to finish...
+  cupsMutexLock(&eve_mutex);
+
+  for (end = cupsGetClock() + timeout; !cache->done && cupsGetClock() < end;)
+    cupsCondWait(&eve_cond, &eve_mutex, end - cupsGetClock());
+
+  cache->waiting = false;
+  done           = cache->done;
+
+  if (!done)
+    cache->generic = true;		// Caller is using generic capabilities
+
+  cupsMutexUnlock(&eve_mutex);
+
+  if (done)
+  {
+    // The probe thread is finished with the data...
+    *response = cache->response;
+    free(cache);
+  }
+
+  return (done);
+}
 
 
 //
-// 'pcl_rstartjob()' - Start a job.
+// 'eve_threads_join()' - Join probe threads.
+//
+// When "all" is `false`, only threads that have finished are joined.
+//
+
+static void
+eve_threads_join(bool all)		// I - Join all threads?
+{
+  eve_thread_t	*thread,		// Current thread
+		**prev,			// Previous pointer in list
+		*joinable = NULL;	// Threads to join
+
+
+  cupsMutexLock(&eve_mutex);
+
+  for (prev = &eve_threads; (thread = *prev) != NULL;)
+  {
+    if (all || thread->finished)
+    {
+      *prev        = thread->next;
+      thread->next = joinable;
+      joinable     = thread;
+    }
+    else
+    {
+      prev = &thread->next;
+    }
+  }
+
+  cupsMutexUnlock(&eve_mutex);
+
+  while ((thread = joinable) != NULL)
+  {
+    joinable = thread->next;
+
+    cupsThreadWait(thread->thread);
+    free(thread);
+  }
+}
+
+
+//
+// 'eve_wait()' - Wait in a probe thread.
+//
+// A timeout of 0 just checks whether the driver is shutting down.
+//
+
+static bool				// O - `true` to continue, `false` on shutdown
+eve_wait(double timeout)		// I - Seconds to wait
+{
+  double	end = cupsGetClock() + timeout;
+					// End time
+  bool		ret;			// Return value
+
+
+  cupsMutexLock(&eve_mutex);
+
+  while (!eve_shutdown && cupsGetClock() < end)
+    cupsCondWait(&eve_cond, &eve_mutex, end - cupsGetClock());
+
+  ret = !eve_shutdown;
+
+  cupsMutexUnlock(&eve_mutex);
+
+  return (ret);
+}
+
+
+//
+// 'get_string()' - Get or allocate a string in the pool.
+//
+// The pool is a hash table that is only ever added to, so lookups don't need
+// a lock.  The media, source, and type keywords used by the PCL and PostScript
+// drivers are added first so that the common strings are never copied.
+//
+
+static const char *			// O - String from pool
+get_string(const char *s)		// I - String to save
+{
+  size_t	i;			// Looping var
+
+
+  if (!atomic_load_explicit(&string_seeded, memory_order_acquire))
+  {
+    // Add the constant strings; this is safe to do from several threads since
+    // a string is only added once...
+    for (i = 0; i < (sizeof(pclps_media) / sizeof(pclps_media[0])); i ++)
+      add_string(pclps_media[i], false);
+    for (i = 0; i < (sizeof(pcl_sources) / sizeof(pcl_sources[0])); i ++)
+      add_string(pcl_sources[i].keyword, false);
+    for (i = 0; i < (sizeof(pcl_data_types) / sizeof(pcl_data_types[0])); i ++)
+      add_string(pcl_data_types[i].keyword, false);
+
+    atomic_store_explicit(&string_seeded, true, memory_order_release);
+  }
+
+  return (add_string(s, true));
+}
+
+
+//
+// 'pcl_compress_data()' - Compress a line of graphics.
+//
+// Each line is encoded using uncompressed (mode 0), TIFF PackBits (mode 2),
+// and delta row (mode 3) compression, and the smallest encoding is sent.
+// Delta row compression encodes the differences from the seed row, which is
+// always the last line that was sent regardless of the compression mode.
+//
+
+static void
+pcl_compress_data(
+    pcl_data_t          *pcl,		// I - Job data
+    pappl_device_t      *device,	// I - Device
+    unsigned            y,		// I - Line number
+    const unsigned char *line,		// I - Data to compress
+    unsigned            length)		// I - Number of bytes
+{
+  const unsigned char	*line_ptr;	// Data to send
+  size_t		packbits_len,	// Length of PackBits data
+			delta_len,	// Length of delta row data
+			line_len;	// Length of data to send
+  int			comp;		// Current compression type
+  char			command[32];	// Raster data command
+  int			command_len;	// Length of command
+
+
+  // Try doing TIFF PackBits and delta row compression...
+  packbits_len = LocalPackBits(pcl->comp_buffer, line, length);
+  delta_len    = pcl_delta_row(pcl->delta_buffer, line, pcl->seed_buffer, length, packbits_len < length ? packbits_len : length);
+
+  if (delta_len < packbits_len && delta_len < length)
+  {
+    // Use delta row compression...
+    comp     = 3;
+    line_ptr = pcl->delta_buffer;
+    line_len = delta_len;
+  }
+  else if (packbits_len <= length)
+  {
+    // Use PackBits compression...
+    comp     = 2;
+    line_ptr = pcl->comp_buffer;
+    line_len = packbits_len;
+  }
+  else
+  {
+    // Don't try compressing...
+    comp     = 0;
+    line_ptr = line;
+    line_len = length;
+  }
+
+  // The current line becomes the seed row for the next line...
+  memcpy(pcl->seed_buffer, line, length);
+
+  // Set compression mode as needed, then the length of the data...
+  if (pcl->compression != comp)
+  {
+    pcl->compression = comp;
+    command_len      = snprintf(command, sizeof(command), "\033*b%dM\033*b%dW", comp, (int)line_len);
+  }
+  else
+  {
+    command_len = snprintf(command, sizeof(command), "\033*b%dW", (int)line_len);
+  }
+
+  // Write a raster plane...
+  pcl_write(pcl, device, command, (size_t)command_len);
+  pcl_write(pcl, device, line_ptr, line_len);
+
+  pcl->raster_bytes += length;
+  pcl->comp_bytes   += line_len;
+}
+
+
+//
+// 'pcl_delta_row()' - Compress a line using delta row (mode 3) compression.
+//
+// Each replacement is a command byte containing the number of bytes (1-8)
+// in the upper 3 bits and the offset from the end of the previous
+// replacement in the lower 5 bits, followed by any extra offset bytes and
+// the replacement bytes.  A line that matches the seed row has no data.
+//
+// Compression stops as soon as the output reaches "limit" bytes, in which
+// case the returned length is not usable.
+//
+
+static size_t				// O - Length of compressed data
+pcl_delta_row(
+    unsigned char       *dst,		// I - Destination buffer
+    const unsigned char *line,		// I - Line to compress
+    const unsigned char *seed,		// I - Seed row
+    size_t              length,		// I - Number of bytes
+    size_t              limit)		// I - Maximum length of compressed data
+{
+  unsigned char	*dst_ptr = dst;		// Pointer into destination
+  size_t	i = 0,			// Current byte
+		pos = 0,		// End of previous replacement
+		start,			// Start of replacement
+		count,			// Number of bytes to replace
+		offset;			// Offset from previous replacement
+
+
+  while (i < length)
+  {
+    // Skip bytes that match the seed row...
+    while (i < length && line[i] == seed[i])
+      i ++;
+
+    if (i >= length)
+      break;
+
+    // Collect up to 8 bytes that differ from the seed row...
+    for (start = i, count = 0; i < length && count < 8 && line[i] != seed[i]; i ++)
+      count ++;
+
+    // Write the command byte and offset...
+    offset   = start - pos;
+    *dst_ptr++ = (unsigned char)(((count - 1) << 5) | (offset < 31 ? offset : 31));
+
+    if (offset >= 31)
+    {
+      for (offset -= 31; offset >= 255; offset -= 255)
+        *dst_ptr++ = 255;
+
+      *dst_ptr++ = (unsigned char)offset;
+    }
+
+    // Then the replacement bytes...
+    memcpy(dst_ptr, line + start, count);
+    dst_ptr += count;
+    pos     = i;
+
+    if ((size_t)(dst_ptr - dst) >= limit)
+      break;
+  }
+
+  return ((size_t)(dst_ptr - dst));
+}
+
+
+//
+// 'pcl_flush()' - Write the output buffer to the device.
 //
 
 static bool				// O - `true` on success, `false` on failure
-pcl_rstartjob(
+pcl_flush(pcl_data_t     *pcl,		// I - Job data
+          pappl_device_t *device)	// I - Device
+{
+  ssize_t	bytes;			// Bytes written
+
+
+  if (pcl->out_used == 0)
+    return (true);
+
+  bytes         = papplDeviceWrite(device, pcl->out_buffer, pcl->out_used);
+  pcl->out_used = 0;
+
+  papplDeviceFlush(device);
+
+  return (bytes >= 0);
+}
+
+
+//
+// 'pcl_lookup()' - Look up the PCL code for a keyword.
+//
+
+static int				// O - PCL code or -1 if not found
+pcl_lookup(const pcl_map_t *map,	// I - Map
+           size_t          num_map,	// I - Number of map entries
+           const char      *keyword)	// I - Keyword
+{
+  for (; num_map > 0; num_map --, map ++)
+  {
+    if (!strcmp(keyword, map->keyword))
+      return (map->value);
+  }
+
+  return (-1);
+}
+
+
+//
+// 'pcl_make_setup()' - Build the page setup commands for the job.
+//
+
+static void
+pcl_make_setup(
+    pcl_data_t         *pcl,		// I - Job data
+    pappl_pr_options_t *options)	// I - Job options
+{
+  char		*ptr,			// Pointer into front side commands
+		*end;			// End of front side commands
+  char		common[128];		// Commands for both sides
+  const char	*duplex;		// Duplex command
+
+
+  // Front side: media position, 6 LPI, 10 CPI, portrait orientation, page
+  // size or length, media type, top margin 0, no perforation skip, and
+  // duplex mode...
+  ptr = pcl->front_setup;
+  end = pcl->front_setup + sizeof(pcl->front_setup);
+
+  if (pcl->source_code >= 0)
+    ptr += snprintf(ptr, (size_t)(end - ptr), "\033&l%dH", pcl->source_code);
+
+  ptr += snprintf(ptr, (size_t)(end - ptr), "\033&l6D\033&k12H\033&l0O");
+
+  if (pcl->size_code >= 0)
+    ptr += snprintf(ptr, (size_t)(end - ptr), "\033&l%dA", pcl->size_code);
+  else
+    ptr += snprintf(ptr, (size_t)(end - ptr), "\033&l%dP", 6 * options->media.size_length / 2540);
+
+  if (pcl->type_code >= 0)
+    ptr += snprintf(ptr, (size_t)(end - ptr), "\033&l%dM", pcl->type_code);
+
+  switch (options->sides)
+  {
+    default :
+	duplex = "";
+	break;
+    case PAPPL_SIDES_ONE_SIDED :
+	duplex = "\033&l0S";
+	break;
+    case PAPPL_SIDES_TWO_SIDED_LONG_EDGE :
+	duplex = "\033&l2S";
+	break;
+    case PAPPL_SIDES_TWO_SIDED_SHORT_EDGE :
+	duplex = "\033&l1S";
+	break;
+  }
+
+  // Both sides: resolution, raster size and position, start graphics...
+  snprintf(common, sizeof(common), "\033*t%uR\033*r%uS\033*r%uT\033&a0H\033&a%.0fV\033*r1A", options->header.HWResolution[0], pcl->width, pcl->height, 720.0 * options->media.top_margin / 2540.0);
+
+  snprintf(ptr, (size_t)(end - ptr), "\033&l0E\033&l0L%s%s", duplex, common);
+  pcl->front_length = strlen(pcl->front_setup);
+
+  snprintf(pcl->back_setup, sizeof(pcl->back_setup), "\033&a2G%s", common);
+  pcl->back_length = strlen(pcl->back_setup);
+
+  pcl->setup_resolution = options->header.HWResolution[0];
+  pcl->setup_width      = pcl->width;
+  pcl->setup_height     = pcl->height;
+}
+
+
+//
+// 'pcl_rendjob()' - End a job.
+//
+
+static bool				// O - `true` on success, `false` on failure
+pcl_rendjob(
     pappl_job_t        *job,		// I - Job
-    pappl_pr_options_t *options,	// I - Job options
+    pappl_pr_options_t *options,	// I - Options
     pappl_device_t     *device)		// I - Device
 {
-  pcl_data_t	*pcl = (pcl_data_t *)calloc(1, sizeof(pcl_data_t));
+  pcl_data_t	*pcl = (pcl_data_t *)job_get_data(job);
 					// Job data
 
 
-  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Starting job...");
-
-  pclps_update_status(papplJobGetPrinter(job), device);
+  job_log(job, PAPPL_LOGLEVEL_DEBUG, "Ending job...");
 
   (void)options;
 
-  papplJobSetData(job, pcl);
-
-  // Send a PCL reset sequence
   papplDevicePuts(device, "\033E");
 
+  LocalMetricsAddDevice(device, &pcl->devmetrics);
+
+  free(pcl);
+  job_set_data(job, NULL);
+
+  pclps_update_status(job_get_printer(job), device);
+
   return (true);
 }
 
 
 //
-// 'pcl_rstartpage()' - Start a page.
+// 'pcl_rendpage()' - End a page.
 //
 
 static bool				// O - `true` on success, `false` on failure
-pcl_rstartpage(
+pcl_rendpage(
     pappl_job_t        *job,		// I - Job
     pappl_pr_options_t *options,	// I - Job options
     pappl_device_t     *device,		// I - Device
     unsigned           page)		// I - Page number
 {
-  size_t	i;			// Looping var
-  cups_page_header_t *header = &(options->header);
-					// Page header
-  pcl_data_t	*pcl = (pcl_data_t *)papplJobGetData(job);
+  pcl_data_t	*pcl = (pcl_data_t *)job_get_data(job);
 					// Job data
-  static const pcl_map_t pcl_sizes[] =	// PCL media size values
-  {
-    { "iso_a3_297x420mm",		27 },
-    { "iso_a4_210x297mm",		26 },
-    { "iso_a5_148x210mm",		25 },
-    { "iso_b5_176x250mm",		100 },
-    { "iso_c5_162x229mm",		91 },
-    { "iso_dl_110x220mm",		90 },
-    { "jis_b5_182x257mm",		45 },
-    { "na_executive_7x10in",		1 },
-    { "na_ledger_11x17in",		6 },
-    { "na_legal_8.5x14in",		3 },
-    { "na_letter_8.5x11in",		2 },
-    { "na_monarch_3.875x7.5in",		80 },
-    { "na_number-10_4.125x9.5in",	81 }
-  };
-  static const pcl_map_t pcl_sources[] =// PCL media source values
-  {
-    { "auto",		7 },
-    { "by-pass-tray",	4 },
-    { "disc",		14 },
-    { "envelope",	6 },
-    { "large-capacity",	5 },
-    { "main",		1 },
-    { "manual",		2 },
-    { "right",		8 },
-    { "tray-1",		20 },
-    { "tray-2",		21 },
-    { "tray-3",		22 },
-    { "tray-4",		23 },
-    { "tray-5",		24 },
-    { "tray-6",		25 },
-    { "tray-7",		26 },
-    { "tray-8",		27 },
-    { "tray-9",		28 },
-    { "tray-10",	29 },
-    { "tray-11",	30 },
-    { "tray-12",	31 },
-    { "tray-13",	32 },
-    { "tray-14",	33 },
-    { "tray-15",	34 },
-    { "tray-16",	35 },
-    { "tray-17",	36 },
-    { "tray-18",	37 },
-    { "tray-19",	38 },
-    { "tray-20",	39 }
-  };
-  static const pcl_map_t pcl_data_types[] =	// PCL media type values
-  {
-    { "disc",			7 },
-    { "photographic",		3 },
-    { "stationery-inkjet",	2 },
-    { "stationery",		0 },
-    { "transparency",		4 }
-  };
 
 
-  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Starting page %u...", page);
+  job_log(job, PAPPL_LOGLEVEL_DEBUG, "Ending page %u...", page);
 
-  // Setup size based on margins...
-  pcl->width  = options->printer_resolution[0] * (options->media.size_width - options->media.left_margin - options->media.right_margin) / 2540;
-  pcl->height = options->printer_resolution[1] * (options->media.size_length - options->media.top_margin - options->media.bottom_margin) / 2540;
-  pcl->xstart = options->printer_resolution[0] * options->media.left_margin / 2540;
-  pcl->xend   = pcl->xstart + pcl->width;
-  pcl->ystart = options->printer_resolution[1] * options->media.top_margin / 2540;
-  pcl->yend   = pcl->ystart + pcl->height;
+  // End graphics and eject the current page, then write the last band...
+  if (options->header.Duplex && (page & 1))
+    pcl_write(pcl, device, "\033*r0B", 5);
+  else
+    pcl_write(pcl, device, "\033*r0B\014", 6);
 
-  // Setup printer/job attributes...
-  if (options->sides == PAPPL_SIDES_ONE_SIDED || (page & 1))
+  if (!pcl_flush(pcl, device))
+    pcl->out_error = true;
+
+  papplDeviceFlush(device);
+
+  LocalMetricsAdd(LOCAL_METRIC_PAGE_PCL, 1, cupsGetClock() - pcl->page_start);
+  LocalMetricsAdd(LOCAL_METRIC_PCL_INPUT, 1, (double)pcl->raster_bytes);
+  LocalMetricsAdd(LOCAL_METRIC_PCL_OUTPUT, 1, (double)pcl->comp_bytes);
+
+  return (!pcl->out_error);
+}
+
+
+//
+// 'pcl_rstartjob()' - Start a job.
+//
+
+static bool				// O - `true` on success, `false` on failure
+pcl_rstartjob(
+    pappl_job_t        *job,		// I - Job
+    pappl_pr_options_t *options,	// I - Job options
+    pappl_device_t     *device)		// I - Device
+{
+  pcl_data_t	*pcl;			// Job data
+  size_t	line_size;		// Size of line buffers
+  unsigned char	*ptr;			// Pointer into job data
+
+
+  job_log(job, PAPPL_LOGLEVEL_DEBUG, "Starting job...");
+
+  // Allocate the job data, output buffer, and line buffers as a single block
+  // that is reused for every page.  The page size is the same for the whole
+  // job...
+  line_size = ((size_t)options->printer_resolution[0] * (size_t)(options->media.size_width - options->media.left_margin - options->media.right_margin) / 2540 + 7) / 8;
+
+  if ((pcl = (pcl_data_t *)calloc(1, sizeof(pcl_data_t) + LocalOutputBuffer + 6 * line_size + 10)) == NULL)
   {
-    // Set media position
-    for (i = 0; i < (sizeof(pcl_sources) / sizeof(pcl_sources[0])); i ++)
-    {
-      if (!strcmp(options->media.source, pcl_sources[i].keyword))
-      {
-	papplDevicePrintf(device, "\033&l%dH", pcl_sources[i].value);
-	break;
-      }
-    }
+    job_log(job, PAPPL_LOGLEVEL_ERROR, "Memory allocation failure.");
+    return (false);
+  }
 
-    // Set 6 LPI, 10 CPI
-    papplDevicePuts(device, "\033&l6D\033&k12H");
+  ptr                = (unsigned char *)(pcl + 1);
+  pcl->out_buffer    = ptr;
+  ptr               += LocalOutputBuffer;
+  pcl->out_size      = LocalOutputBuffer;
+  pcl->line_buffer   = ptr;
+  ptr               += line_size;
+  pcl->comp_buffer   = ptr;
+  ptr               += 2 * line_size + 2;
+  pcl->delta_buffer  = ptr;
+  ptr               += 2 * line_size + 8;
+  pcl->seed_buffer   = ptr;
+  pcl->max_line_size = line_size;
 
-    // Set portrait orientation
-    papplDevicePuts(device, "\033&l0O");
+  // Look up the PCL codes for the job's media...
+  pcl->source_code = pcl_lookup(pcl_sources, sizeof(pcl_sources) / sizeof(pcl_sources[0]), options->media.source);
+  pcl->size_code   = pcl_lookup(pcl_sizes, sizeof(pcl_sizes) / sizeof(pcl_sizes[0]), options->media.size_name);
+  pcl->type_code   = pcl_lookup(pcl_data_types, sizeof(pcl_data_types) / sizeof(pcl_data_types[0]), options->media.type);
 
-    // Set page size
-    for (i = 0; i < (sizeof(pcl_sizes) / sizeof(pcl_sizes[0])); i ++)
-    {
-      if (!strcmp(options->media.size_name, pcl_sizes[i].keyword))
-      {
-	papplDevicePrintf(device, "\033&l%dA", pcl_sizes[i].value);
-	break;
-      }
-    }
+  pclps_update_status(job_get_printer(job), device);
 
-    if (i >= (sizeof(pcl_sizes) / sizeof(pcl_sizes[0])))
-    {
-      // Custom size, set page length...
-      papplDevicePrintf(device, "\033&l%dP", 6 * options->media.size_length / 2540);
-    }
+  job_set_data(job, pcl);
+
+  papplDeviceGetMetrics(device, &pcl->devmetrics);
+
+  // Send a PCL reset sequence
+  papplDevicePuts(device, "\033E");
+
+  return (true);
+}
 
-    // Set media type
-    for (i = 0; i < (sizeof(pcl_data_types) / sizeof(pcl_data_types[0])); i ++)
-    {
-      if (!strcmp(options->media.type, pcl_data_types[i].keyword))
-      {
-	papplDevicePrintf(device, "\033&l%dM", pcl_data_types[i].value);
-	break;
-      }
-    }
 
-    // Set top margin to 0
-    papplDevicePuts(device, "\033&l0E");
+//
+// 'pcl_rstartpage()' - Start a page.
+//
 
-    // Turn off perforation skip
-    papplDevicePuts(device, "\033&l0L");
+static bool				// O - `true` on success, `false` on failure
+pcl_rstartpage(
+    pappl_job_t        *job,		// I - Job
+    pappl_pr_options_t *options,	// I - Job options
+    pappl_device_t     *device,		// I - Device
+    unsigned           page)		// I - Page number
+{
+  cups_page_header_t *header = &(options->header);
+					// Page header
+  pcl_data_t	*pcl = (pcl_data_t *)job_get_data(job);
+					// Job data
 
-    // Set duplex mode...
-    switch (options->sides)
-    {
-      case PAPPL_SIDES_ONE_SIDED :
-	  papplDevicePuts(device, "\033&l0S");
-	  break;
-      case PAPPL_SIDES_TWO_SIDED_LONG_EDGE :
-	  papplDevicePuts(device, "\033&l2S");
-	  break;
-      case PAPPL_SIDES_TWO_SIDED_SHORT_EDGE :
-	  papplDevicePuts(device, "\033&l1S");
-	  break;
-    }
-  }
-  else
-  {
-    // Set back side
-    papplDevicePuts(device, "\033&a2G");
-  }
 
-  // Set resolution
-  papplDevicePrintf(device, "\033*t%uR", header->HWResolution[0]);
+  job_log(job, PAPPL_LOGLEVEL_DEBUG, "Starting page %u...", page);
 
-  // Set size
-  papplDevicePrintf(device, "\033*r%uS\033*r%uT", pcl->width, pcl->height);
+  // Stop if a previous page could not be written...
+  if (pcl->out_error)
+    return (false);
 
-  // Set position
-  papplDevicePrintf(device, "\033&a0H\033&a%.0fV", 720.0 * options->media.top_margin / 2540.0);
+  pcl->page_start   = cupsGetClock();
+  pcl->raster_bytes = 0;
+  pcl->comp_bytes   = 0;
 
-  // Start graphics
-  papplDevicePuts(device, "\033*r1A");
+  // Setup size based on margins...
+  pcl->width  = options->printer_resolution[0] * (options->media.size_width - options->media.left_margin - options->media.right_margin) / 2540;
+  pcl->height = options->printer_resolution[1] * (options->media.size_length - options->media.top_margin - options->media.bottom_margin) / 2540;
+  pcl->xstart = options->printer_resolution[0] * options->media.left_margin / 2540;
+  pcl->xend   = pcl->xstart + pcl->width;
+  pcl->ystart = options->printer_resolution[1] * options->media.top_margin / 2540;
+  pcl->yend   = pcl->ystart + pcl->height;
 
-  // Allocate dithering plane buffers
   pcl->line_size = (pcl->width + 7) / 8;
 
-  if ((pcl->line_buffer = malloc(pcl->line_size)) == NULL)
+  if (pcl->line_size > pcl->max_line_size)
   {
-    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Memory allocation failure.");
+    job_log(job, PAPPL_LOGLEVEL_ERROR, "Page %u is wider than the job's line buffers.", page);
     return (false);
   }
 
-  // No blank lines yet...
+  // Send the page setup commands, which only need to be built again if the
+  // page header changes...
+  if (!pcl->front_length || pcl->setup_resolution != header->HWResolution[0] || pcl->setup_width != pcl->width || pcl->setup_height != pcl->height)
+    pcl_make_setup(pcl, options);
+
+  if (options->sides == PAPPL_SIDES_ONE_SIDED || (page & 1))
+    pcl_write(pcl, device, pcl->front_setup, pcl->front_length);
+  else
+    pcl_write(pcl, device, pcl->back_setup, pcl->back_length);
+
+  // No blank lines yet, and start with a blank seed row...
   pcl->feed = 0;
 
-  // Allocate memory for compression...
-  if ((pcl->comp_buffer = malloc(pcl->line_size * 2 + 2)) == NULL)
-  {
-    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Memory allocation failure.");
-    return (false);
-  }
+  memset(pcl->seed_buffer, 0, pcl->line_size);
 
   return (true);
 }
@@ -1182,13 +2050,9 @@ pcl_rwriteline(
 {
   cups_page_header_t	*header = &(options->header);
 					// Page header
-  pcl_data_t		*pcl = (pcl_data_t *)papplJobGetData(job);
+  pcl_data_t		*pcl = (pcl_data_t *)job_get_data(job);
 					// Job data
-  unsigned		x;		// Current column
-  const unsigned char	*pixptr;	// Pixel pointer in line
-  unsigned char		bit,		// Current plane data
-			*kptr,		// Pointer into k-plane
-			byte;		// Byte in line
+  unsigned char		byte;		// Byte in line
   const unsigned char	*dither;	// Dither line
 
 
@@ -1197,7 +2061,7 @@ pcl_rwriteline(
     return (true);
 
   if (!(y & 127))
-    papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Printing line %u (%u%%)", y, 100 * (y - pcl->ystart) / pcl->height);
+    job_log(job, PAPPL_LOGLEVEL_DEBUG, "Printing line %u (%u%%)", y, 100 * (y - pcl->ystart) / pcl->height);
 
   // Check whether the line is all whitespace...
   byte = options->header.cupsColorSpace == CUPS_CSPACE_K ? 0 : 255;
@@ -1207,7 +2071,12 @@ pcl_rwriteline(
     // No, skip previous whitespace as needed...
     if (pcl->feed > 0)
     {
-      papplDevicePrintf(device, "\033*b%dY", pcl->feed);
+      // Skipping lines clears the seed row...
+      char	command[32];		// Y offset command
+      int	command_len = snprintf(command, sizeof(command), "\033*b%dY", pcl->feed);
+
+      pcl_write(pcl, device, command, (size_t)command_len);
+      memset(pcl->seed_buffer, 0, pcl->line_size);
       pcl->feed = 0;
     }
 
@@ -1216,50 +2085,8 @@ pcl_rwriteline(
 
     if (header->cupsBitsPerPixel == 8)
     {
-      memset(pcl->line_buffer, 0, pcl->line_size);
-
-      if (header->cupsColorSpace == CUPS_CSPACE_K)
-      {
-	// 8 bit black
-	for (x = pcl->xstart, kptr = pcl->line_buffer, pixptr = pixels + pcl->xstart, bit = 128, byte = 0; x < pcl->xend; x ++, pixptr ++)
-	{
-	  if (*pixptr >= dither[x & 15])
-	    byte |= bit;
-
-	  if (bit == 1)
-	  {
-	    *kptr++ = byte;
-	    byte    = 0;
-	    bit     = 128;
-	  }
-	  else
-	    bit /= 2;
-	}
-
-	if (bit < 128)
-	  *kptr = byte;
-      }
-      else
-      {
-	// 8 bit gray
-	for (x = pcl->xstart, kptr = pcl->line_buffer, pixptr = pixels + pcl->xstart, bit = 128, byte = 0; x < pcl->xend; x ++, pixptr ++)
-	{
-	  if (*pixptr < dither[x & 15])
-	    byte |= bit;
-
-	  if (bit == 1)
-	  {
-	    *kptr++ = byte;
-	    byte    = 0;
-	    bit     = 128;
-	  }
-	  else
-	    bit /= 2;
-	}
-
-	if (bit < 128)
-	  *kptr = byte;
-      }
+      // 8 bit black or gray
+      LocalDitherLine(pcl->line_buffer, pixels + pcl->xstart, pcl->width, dither, pcl->xstart, header->cupsColorSpace == CUPS_CSPACE_K);
     }
     else
     {
@@ -1268,20 +2095,57 @@ pcl_rwriteline(
     }
 
     pcl_compress_data(pcl, device, y, pcl->line_buffer, pcl->line_size);
-    papplDeviceFlush(device);
   }
   else
   {
     pcl->feed ++;
   }
 
-  return (true);
+  return (!pcl->out_error);
+}
+
+
+//
+// 'pcl_write()' - Add data to the output buffer.
+//
+// The buffer is written to the device when it fills up, so a band of lines
+// is sent with a single write.
+//
+
+static void
+pcl_write(pcl_data_t     *pcl,		// I - Job data
+          pappl_device_t *device,	// I - Device
+          const void     *data,		// I - Data
+          size_t         length)	// I - Number of bytes
+{
+  if ((pcl->out_used + length) > pcl->out_size)
+  {
+    // Send the current band...
+    if (!pcl_flush(pcl, device))
+      pcl->out_error = true;
+
+    if (length > pcl->out_size)
+    {
+      // Too big to buffer, write directly...
+      if (papplDeviceWrite(device, data, length) < 0)
+        pcl->out_error = true;
+      return;
+    }
+  }
+
+  memcpy(pcl->out_buffer + pcl->out_used, data, length);
+  pcl->out_used += length;
 }
 
 
 //
 // 'pclps_print()' - Print file.
 //
+// The file is mapped into memory and written straight from the mapping, so
+// the data is not copied through a separate read buffer.  Files that cannot
+// be mapped are copied using read().  Progress is reported in bytes through
+// the job's state message.
+//
 
 static bool				// O - `true` on success, `false` on failure
 pclps_print(
@@ -1291,31 +2155,105 @@ pclps_print(
     pappl_device_t     *device)		// I - Device
 {
   int		fd;			// Job file
+  struct stat	fileinfo;		// Job file information
+  unsigned char	*map = MAP_FAILED;	// Memory-mapped file
+  off_t		total = 0;		// Total bytes sent
   ssize_t	bytes;			// Bytes read/written
-  char		buffer[65536];		// Read/write buffer
+  bool		ret = true;		// Return value
+  pappl_devmetrics_t devmetrics;	// Device metrics at start
 
 
-  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Printing raw file...");
+  (void)options;
+
+  job_log(job, PAPPL_LOGLEVEL_DEBUG, "Printing raw file...");
 
   papplJobSetImpressions(job, 1);
 
-  fd = open(papplJobGetDocumentFilename(job, doc_number), O_RDONLY);
+  papplDeviceGetMetrics(device, &devmetrics);
 
-  while ((bytes = read(fd, buffer, sizeof(buffer))) > 0)
+  if ((fd = open(papplJobGetDocumentFilename(job, doc_number), O_RDONLY)) < 0 || fstat(fd, &fileinfo))
   {
-    if (papplDeviceWrite(device, buffer, (size_t)bytes) < 0)
-    {
-      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to send %d bytes to printer.", (int)bytes);
+    job_log(job, PAPPL_LOGLEVEL_ERROR, "Unable to open print file: %s", strerror(errno));
+    if (fd >= 0)
       close(fd);
-      return (false);
+    return (false);
+  }
+
+  if (fileinfo.st_size > 0 && (map = mmap(NULL, (size_t)fileinfo.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) != MAP_FAILED)
+  {
+    // Write directly from the mapped file...
+    madvise(map, (size_t)fileinfo.st_size, MADV_SEQUENTIAL);
+
+    while (total < fileinfo.st_size)
+    {
+      if (papplJobIsCanceled(job))
+      {
+        ret = false;
+        break;
+      }
+
+      if ((bytes = (ssize_t)(fileinfo.st_size - total)) > PCLPS_CHUNK)
+        bytes = PCLPS_CHUNK;
+
+      if (papplDeviceWrite(device, map + total, (size_t)bytes) < 0)
+      {
+	job_log(job, PAPPL_LOGLEVEL_ERROR, "Unable to send %d bytes to printer.", (int)bytes);
+	ret = false;
+	break;
+      }
+
+      total += bytes;
+      papplJobSetMessage(job, "Sent %lld of %lld bytes.", (long long)total, (long long)fileinfo.st_size);
+    }
+
+    munmap(map, (size_t)fileinfo.st_size);
+  }
+  else
+  {
+    // Copy the file using a read buffer...
+    char	buffer[65536];		// Read/write buffer
+
+    while ((bytes = read(fd, buffer, sizeof(buffer))) != 0)
+    {
+      if (bytes < 0)
+      {
+        if (errno == EINTR || errno == EAGAIN)
+          continue;
+
+	job_log(job, PAPPL_LOGLEVEL_ERROR, "Unable to read print file: %s", strerror(errno));
+	ret = false;
+	break;
+      }
+
+      if (papplJobIsCanceled(job))
+      {
+        ret = false;
+        break;
+      }
+
+      if (papplDeviceWrite(device, buffer, (size_t)bytes) < 0)
+      {
+	job_log(job, PAPPL_LOGLEVEL_ERROR, "Unable to send %d bytes to printer.", (int)bytes);
+	ret = false;
+	break;
+      }
+
+      total += bytes;
+      if (!(total % PCLPS_CHUNK) || total == fileinfo.st_size)
+        papplJobSetMessage(job, "Sent %lld of %lld bytes.", (long long)total, (long long)fileinfo.st_size);
     }
   }
 
   close(fd);
 
-  papplJobSetImpressionsCompleted(job, 1);
+  job_log(job, PAPPL_LOGLEVEL_DEBUG, "Sent %lld bytes to printer.", (long long)total);
 
-  return (true);
+  LocalMetricsAddDevice(device, &devmetrics);
+
+  if (ret)
+    papplJobSetImpressionsCompleted(job, 1);
+
+  return (ret);
 }
 
 
@@ -1389,18 +2327,127 @@ pclps_update_status(
 }
 
 
+//
+// 'ps_ascii85()' - Add ASCII85-encoded data to the output buffer.
+//
+// Partial groups of 4 bytes are kept for the next call.  When "eod" is
+// `true`, the last group and the "~>" end-of-data marker are written.
+//
+
+static void
+ps_ascii85(
+    ps_data_t           *ps,		// I - Job data
+    pappl_device_t      *device,	// I - Device
+    const unsigned char *data,		// I - Data to encode
+    size_t              length,		// I - Number of bytes
+    bool                eod)		// I - `true` for end-of-data
+{
+  unsigned	i;			// Looping var
+  unsigned	count;			// Number of bytes in group
+  uint32_t	b;			// Binary data
+  char		c[5];			// ASCII85 characters
+
+
+  while (length > 0 || (eod && ps->a85_count > 0))
+  {
+    // Fill the current group...
+    while (length > 0 && ps->a85_count < 4)
+    {
+      ps->a85_buffer[ps->a85_count ++] = *data++;
+      length --;
+    }
+
+    if (ps->a85_count < 4 && !eod)
+      break;
+
+    // Encode the group, padding a partial group with zeros...
+    for (i = ps->a85_count; i < 4; i ++)
+      ps->a85_buffer[i] = 0;
+
+    count         = ps->a85_count;
+    ps->a85_count = 0;
+    b             = ((uint32_t)ps->a85_buffer[0] << 24) | ((uint32_t)ps->a85_buffer[1] << 16) | ((uint32_t)ps->a85_buffer[2] << 8) | ps->a85_buffer[3];
+
+    if (b == 0 && count == 4)
+    {
+      ps_write(ps, device, "z", 1);
+    }
+    else
+    {
+      for (i = 5; i > 0; i --, b /= 85)
+        c[i - 1] = (char)('!' + b % 85);
+
+      ps_write(ps, device, c, count + 1);
+    }
+
+    // Keep lines short...
+    if (ps->a85_column >= 75)
+    {
+      ps_write(ps, device, "\n", 1);
+      ps->a85_column = 0;
+    }
+  }
+
+  if (eod)
+  {
+    ps_write(ps, device, "~>\n", 3);
+    ps->a85_column = 0;
+  }
+}
+
+
+//
+// 'ps_flush()' - Write the output buffer to the device.
+//
+
+static bool				// O - `true` on success, `false` on failure
+ps_flush(ps_data_t      *ps,		// I - Job data
+         pappl_device_t *device)	// I - Device
+{
+  ssize_t	bytes;			// Bytes written
+
+
+  if (ps->out_used == 0)
+    return (true);
+
+  bytes        = papplDeviceWrite(device, ps->out_buffer, ps->out_used);
+  ps->out_used = 0;
+
+  return (bytes >= 0);
+}
+
+
 //
 // 'ps_rendjob()' - End a graphics job.
 //
 
-static bool
-ps_rendjob(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device)
+static bool				// O - `true` on success, `false` on failure
+ps_rendjob(
+    pappl_job_t        *job,		// I - Job
+    pappl_pr_options_t *options,	// I - Options
+    pappl_device_t     *device)		// I - Device
 {
-  (void)job;
+  ps_data_t	*ps = (ps_data_t *)job_get_data(job);
+					// Job data
+
+
+  job_log(job, PAPPL_LOGLEVEL_DEBUG, "Ending job...");
+
   (void)options;
-  (void)device;
 
-  return (false);
+  papplDevicePrintf(device, "%%%%Trailer\n%%%%Pages: %u\n%%%%EOF\n", ps->pages);
+  papplDeviceFlush(device);
+
+  LocalMetricsAddDevice(device, &ps->devmetrics);
+
+  free(ps->comp_buffer);
+  free(ps->out_buffer);
+  free(ps);
+  job_set_data(job, NULL);
+
+  pclps_update_status(job_get_printer(job), device);
+
+  return (true);
 }
 
 
@@ -1408,30 +2455,79 @@ ps_rendjob(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device
 // 'ps_rendpage()' - End a page of graphics.
 //
 
-static bool
-ps_rendpage(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device, unsigned page)
+static bool				// O - `true` on success, `false` on failure
+ps_rendpage(
+    pappl_job_t        *job,		// I - Job
+    pappl_pr_options_t *options,	// I - Job options
+    pappl_device_t     *device,		// I - Device
+    unsigned           page)		// I - Page number
 {
-  (void)job;
+  ps_data_t	*ps = (ps_data_t *)job_get_data(job);
+					// Job data
+  bool		ret;			// Return value
+  static const unsigned char eod = 128;	// RunLengthDecode end-of-data
+
+
+  job_log(job, PAPPL_LOGLEVEL_DEBUG, "Ending page %u...", page);
+
   (void)options;
-  (void)device;
-  (void)page;
 
-  return (false);
+  // Finish the image data and eject the page...
+  ps_ascii85(ps, device, &eod, 1, true);
+  ret = ps_flush(ps, device);
+
+  papplDevicePuts(device, "grestore\nshowpage\n");
+  papplDeviceFlush(device);
+
+  LocalMetricsAdd(LOCAL_METRIC_PAGE_PS, 1, cupsGetClock() - ps->page_start);
+
+  return (ret);
 }
 
 
 //
 // 'ps_rstartjob()' - Start a graphics job.
 //
+// The prolog defines a "cupslocaldimage" procedure that draws an image using
+// RunLength-compressed, ASCII85-encoded data that follows in the job file,
+// and then flushes both filters so that the interpreter picks up again after
+// the "~>" end-of-data marker.
+//
 
-static bool
-ps_rstartjob(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device)
+static bool				// O - `true` on success, `false` on failure
+ps_rstartjob(
+    pappl_job_t        *job,		// I - Job
+    pappl_pr_options_t *options,	// I - Job options
+    pappl_device_t     *device)		// I - Device
 {
-  (void)job;
-  (void)options;
-  (void)device;
+  ps_data_t	*ps;			// Job data
+
+
+  job_log(job, PAPPL_LOGLEVEL_DEBUG, "Starting job...");
+
+  if ((ps = (ps_data_t *)calloc(1, sizeof(ps_data_t))) == NULL || (ps->out_buffer = malloc(LocalOutputBuffer)) == NULL)
+  {
+    job_log(job, PAPPL_LOGLEVEL_ERROR, "Memory allocation failure.");
+    free(ps);
+    return (false);
+  }
+
+  ps->out_size = LocalOutputBuffer;
+
+  pclps_update_status(job_get_printer(job), device);
+
+  job_set_data(job, ps);
+
+  papplDeviceGetMetrics(device, &ps->devmetrics);
+
+  // Send the document header and prolog...
+  papplDevicePuts(device, "%!PS-Adobe-3.0\n%%LanguageLevel: 2\n%%Creator: cupslocald\n%%Pages: (atend)\n%%EndComments\n");
+  papplDevicePuts(device, "%%BeginProlog\n/cupslocaldimage{currentfile/ASCII85Decode filter dup/RunLengthDecode filter 3 -1 roll dup/DataSource 3 index put image flushfile flushfile}bind def\n%%EndProlog\n");
 
-  return (false);
+  // Then the media size and duplex mode...
+  papplDevicePrintf(device, "%%%%BeginSetup\n<</PageSize[%d %d]/Duplex %s/Tumble %s>>setpagedevice\n%%%%EndSetup\n", 72 * options->media.size_width / 2540, 72 * options->media.size_length / 2540, options->sides == PAPPL_SIDES_ONE_SIDED ? "false" : "true", options->sides == PAPPL_SIDES_TWO_SIDED_SHORT_EDGE ? "true" : "false");
+
+  return (true);
 }
 
 
@@ -1439,30 +2535,117 @@ ps_rstartjob(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *devi
 // 'ps_rstartpage()' - Start a page of graphics.
 //
 
-static bool
-ps_rstartpage(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device, unsigned page)
+static bool				// O - `true` on success, `false` on failure
+ps_rstartpage(
+    pappl_job_t        *job,		// I - Job
+    pappl_pr_options_t *options,	// I - Job options
+    pappl_device_t     *device,		// I - Device
+    unsigned           page)		// I - Page number
 {
-  (void)job;
-  (void)options;
-  (void)device;
-  (void)page;
+  cups_page_header_t *header = &(options->header);
+					// Page header
+  ps_data_t	*ps = (ps_data_t *)job_get_data(job);
+					// Job data
+  const char	*colorspace,		// Color space
+		*decode;		// Decode array
+
+
+  job_log(job, PAPPL_LOGLEVEL_DEBUG, "Starting page %u...", page);
+
+  ps->page_start = cupsGetClock();
+
+  // Allocate memory for compression, reusing the buffer from the previous
+  // page when it is large enough...
+  ps->line_size = header->cupsBytesPerLine;
+
+  if ((ps->line_size * 2 + 2) > ps->comp_size)
+  {
+    free(ps->comp_buffer);
+
+    ps->comp_size = ps->line_size * 2 + 2;
+
+    if ((ps->comp_buffer = malloc(ps->comp_size)) == NULL)
+    {
+      job_log(job, PAPPL_LOGLEVEL_ERROR, "Memory allocation failure.");
+      ps->comp_size = 0;
+      return (false);
+    }
+  }
+
+  ps->pages ++;
 
-  return (false);
+  // Map the raster color space to PostScript...
+  switch (header->cupsColorSpace)
+  {
+    case CUPS_CSPACE_K :
+        colorspace = "DeviceGray";
+        decode     = "1 0";
+        break;
+
+    case CUPS_CSPACE_SRGB :
+    case CUPS_CSPACE_RGB :
+        colorspace = "DeviceRGB";
+        decode     = "0 1 0 1 0 1";
+        break;
+
+    default :
+        colorspace = "DeviceGray";
+        decode     = "0 1";
+        break;
+  }
+
+  // Scale the image to the page and start the image data...
+  papplDevicePrintf(device, "%%%%Page: %u %u\ngsave\n%.3f %.3f scale\n/%s setcolorspace\n", ps->pages, ps->pages, 72.0 * header->cupsWidth / header->HWResolution[0], 72.0 * header->cupsHeight / header->HWResolution[1], colorspace);
+  papplDevicePrintf(device, "<</ImageType 1/Width %u/Height %u/BitsPerComponent %u/Decode[%s]/ImageMatrix[%u 0 0 -%u 0 %u]>>cupslocaldimage\n", header->cupsWidth, header->cupsHeight, header->cupsBitsPerColor, decode, header->cupsWidth, header->cupsHeight, header->cupsHeight);
+
+  return (true);
 }
 
 
 //
 // 'ps_rwriteline()' - Write a line of graphics.
 //
+// Each line is compressed using the RunLengthDecode format, which is the same
+// as TIFF PackBits, and is added to the output buffer.  The buffer is written
+// to the device whenever it fills up, so only one band of the page is held
+// in memory at a time.
+//
+
+static bool				// O - `true` on success, `false` on failure
+ps_rwriteline(
+    pappl_job_t         *job,		// I - Job
+    pappl_pr_options_t  *options,	// I - Job options
+    pappl_device_t      *device,	// I - Device
+    unsigned            y,		// I - Line number
+    const unsigned char *pixels)	// I - Line
+{
+  ps_data_t	*ps = (ps_data_t *)job_get_data(job);
+					// Job data
+
+
+  if (!(y & 127))
+    job_log(job, PAPPL_LOGLEVEL_DEBUG, "Printing line %u (%u%%)", y, 100 * y / options->header.cupsHeight);
+
+  ps_ascii85(ps, device, ps->comp_buffer, LocalPackBits(ps->comp_buffer, pixels, ps->line_size), false);
+
+  return (!ps->out_error);
+}
+
+
+//
+// 'ps_write()' - Add data to the output buffer.
+//
 
-static bool
-ps_rwriteline(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device, unsigned y, const unsigned char *pixels)
+static void
+ps_write(ps_data_t      *ps,		// I - Job data
+         pappl_device_t *device,	// I - Device
+         const char     *data,		// I - Data
+         size_t         length)		// I - Number of bytes
 {
-  (void)job;
-  (void)options;
-  (void)device;
-  (void)y;
-  (void)pixels;
+  if ((ps->out_used + length) > ps->out_size && !ps_flush(ps, device))
+    ps->out_error = true;
 
-  return (false);
+  memcpy(ps->out_buffer + ps->out_used, data, length);
+  ps->out_used   += length;
+  ps->a85_column += (unsigned)length;
 }
@@ -68,6 +68,31 @@ main(int  argc,				// I - Number of command-line arguments
       {
         switch (*opt)
 	{
+	  case 'b' : // -b BYTES
+	      i ++;
+	      if (i >= argc || !isdigit(argv[i][0] & 255))
+	      {
+	        cupsLangPrintf(stderr, _("%s: Missing output buffer size after '-b'."), "cups-locald");
+	        return (usage(stderr));
+	      }
+	      else if ((LocalOutputBuffer = (size_t)atoi(argv[i])) < LOCAL_MIN_OUTPUT)
+	      {
+	        cupsLangPrintf(stderr, _("%s: Output buffer size must be at least %d bytes."), "cups-locald", LOCAL_MIN_OUTPUT);
+	        return (usage(stderr));
+	      }
+	      break;
+
+	  case 'c' : // -c BYTES
+	      i ++;
+	      if (i >= argc || !isdigit(argv[i][0] & 255))
+	      {
+	        cupsLangPrintf(stderr, _("%s: Missing transform cache size after '-c'."), "cups-locald");
+	        return (usage(stderr));
+	      }
+
+	      LocalTransformCache = (size_t)strtoul(argv[i], NULL, 10);
+	      break;
+
 	  case 'd' : // -d SPOOLDIR
 	      i ++;
 	      if (i >= argc)
@@ -143,6 +168,28 @@ main(int  argc,				// I - Number of command-line arguments
 	      cupsCopyString(LocalStateFile, argv[i], sizeof(LocalStateFile));
 	      break;
 
+	  case 't' : // -t TRANSFORMS
+	      i ++;
+	      if (i >= argc || !isdigit(argv[i][0] & 255))
+	      {
+	        cupsLangPrintf(stderr, _("%s: Missing number of transforms after '-t'."), "cups-locald");
+	        return (usage(stderr));
+	      }
+
+	      LocalTransformLimit = atoi(argv[i]);
+	      break;
+
+	  case 'w' : // -w WORKERS
+	      i ++;
+	      if (i >= argc || !isdigit(argv[i][0] & 255))
+	      {
+	        cupsLangPrintf(stderr, _("%s: Missing number of workers after '-w'."), "cups-locald");
+	        return (usage(stderr));
+	      }
+
+	      LocalTransformWorkers = atoi(argv[i]);
+	      break;
+
 	  default : //
 	      cupsLangPrintf(stderr, _("%s: Unknown option '-%c'."), "cups-locald", *opt);
 	      return (usage(stderr));
@@ -206,7 +253,7 @@ main(int  argc,				// I - Number of command-line arguments
 
   // Create the system object...
   system = papplSystemCreate(PAPPL_SOPTIONS_MULTI_QUEUE, "cups-locald", /*port*/0, /*subtypes*/NULL, LocalSpoolDir, log_file, log_level, /*auth_service*/NULL, /*tls_only*/false);
-  papplSystemSetIdleShutdown(system, 120);
+  papplSystemSetIdleShutdown(system, LOCAL_IDLE_SHUTDOWN);
 
   // Load/save state to the state file...
   if (!papplSystemLoadState(system, LocalStateFile))
@@ -250,6 +297,9 @@ main(int  argc,				// I - Number of command-line arguments
 
   papplSystemAddListeners(system, "localhost");
 
+  // Serve metrics for monitoring...
+  papplSystemAddResourceCallback(system, "/metrics", "text/plain", (pappl_resource_cb_t)LocalMetricsCallback, system);
+
   // Setup the generic drivers...
   papplSystemSetPrinterDrivers(system, sizeof(LocalDrivers) / sizeof(LocalDrivers[0]), LocalDrivers, LocalDriverAutoAdd, /* create_cb */NULL, LocalDriverCallback, NULL);
 
@@ -266,6 +316,9 @@ main(int  argc,				// I - Number of command-line arguments
   papplSystemAddMIMEFilter(system, "text/plain", "image/pwg-raster", LocalTransformFilter, NULL);
   papplSystemAddMIMEFilter(system, "text/plain", "image/urf", LocalTransformFilter, NULL);
 
+  // Stop idle transform workers...
+  papplSystemAddTimerCallback(system, /*start*/0, LOCAL_WORKER_IDLE / 4, LocalTransformTimer, NULL);
+
 #ifdef HAVE_DBUS
   // Start a background thread for D-Bus...
   dbus = cupsThreadCreate(LocalDBusService, /*arg*/NULL);
@@ -274,12 +327,17 @@ main(int  argc,				// I - Number of command-line arguments
   // Run until we are no longer needed...
   papplSystemRun(system);
 
+  // Stop probing printers before freeing the system...
+  LocalDriverShutdown();
+
 #ifdef HAVE_DBUS
   // Stop background thread for D-Bus...
   cupsThreadCancel(dbus);
   cupsThreadWait(dbus);
 #endif // HAVE_DBUS
 
+  papplSystemDelete(system);
+
   return (0);
 }
 
@@ -296,11 +354,15 @@ usage(FILE *out)			// I - Output file
   cupsLangPuts(out, _("Options:"));
   cupsLangPuts(out, _("--help                         Show this help"));
   cupsLangPuts(out, _("--version                      Show the program version"));
+  cupsLangPuts(out, _("-b BYTES                       Set the printer output buffer size"));
+  cupsLangPuts(out, _("-c BYTES                       Set the transform cache size (0 to disable)"));
   cupsLangPuts(out, _("-d SPOOLDIR                    Set the spool directory"));
   cupsLangPuts(out, _("-L LOGLEVEL                    Set the log level (error,warn,info,debug)"));
   cupsLangPuts(out, _("-l LOGFILE                     Set the log file"));
   cupsLangPuts(out, _("-S SOCKETFILE                  Set the domain socket file"));
   cupsLangPuts(out, _("-s STATEFILE                   Set the state/configuration file"));
+  cupsLangPuts(out, _("-t TRANSFORMS                  Set the maximum number of concurrent transforms (0 for one per CPU)"));
+  cupsLangPuts(out, _("-w WORKERS                     Set the number of transform workers (0 to disable)"));
 
   return (out == stdout ? 0 : 1);
 }
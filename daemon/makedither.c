@@ -0,0 +1,210 @@
+//
+// Dither matrix generator for cupslocald.
+//
+// Usage:
+//
+//   ./makedither [-g GAMMA] [-p GAMMA] [-m FILENAME] >dither.h
+//
+// The "-g" and "-p" options set the gamma correction for the graphics and
+// photo matrices (default 0.4545).  The "-m" option reads an alternate 16x16
+// matrix as 256 whitespace-separated values from 0 to 255.
+//
+// Copyright © 2025 by OpenPrinting.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+
+//
+// Local globals...
+//
+
+static unsigned char	dither[16][16] =// Blue-noise dither array
+{
+  { 111,  49, 142, 162, 113, 195,  71, 177, 201,  50, 151,  94,  66,  37,  85, 252 },
+  {  25,  99, 239, 222,  32, 250, 148,  19,  38, 106, 220, 170, 194, 138,  13, 167 },
+  { 125, 178,  79,  15,  65, 173, 123,  87, 213, 131, 247,  23, 116,  54, 229, 212 },
+  {  41, 202, 152, 132, 189, 104,  53, 236, 161,  62,   1, 181,  77, 241, 147,  68 },
+  {   2, 244,  56,  91, 230,   5, 204,  28, 187, 101, 144, 206,  33,  92, 190, 107 },
+  { 223, 164, 114,  36, 214, 156, 139,  70, 245,  84, 226,  48, 126, 158,  17, 135 },
+  {  83, 196,  21, 254,  76,  45, 179, 115,  12,  40, 169, 105, 253, 176, 211,  59 },
+  { 100, 180, 145, 122, 172,  97, 235, 129, 215, 149, 199,   8,  72,  26, 238,  44 },
+  { 232,  31,  69,  11, 205,  58,  18, 193,  88,  60, 112, 221, 140,  86, 120, 153 },
+  { 208, 130, 243, 160, 224, 110,  34, 248, 165,  24, 234, 184,  52, 198, 171,   6 },
+  { 108, 188,  51,  89, 137, 186, 154,  78,  47, 134,  98, 157,  35, 249,  95,  63 },
+  {  16,  75, 219,  39,   0,  67, 228, 121, 197, 240,   3,  74, 127,  20, 227, 143 },
+  { 246, 175, 119, 200, 251, 103, 146,  14, 209, 174, 109, 218, 192,  82, 203, 163 },
+  {  29,  93, 150,  22, 166, 182,  55,  30,  90,  64,  42, 141, 168,  57, 117,  46 },
+  { 216, 233,  61, 128,  81, 237, 217, 118, 159, 255, 185,  27, 242, 102,   4, 133 },
+  {  73, 191,   9, 210,  43,  96,   7, 136, 231,  80,  10, 124, 225, 207, 155, 183 }
+};
+
+
+//
+// Local functions...
+//
+
+static int	read_matrix(const char *filename);
+static int	usage(FILE *fp);
+static void	write_matrix(const char *name, double gamma);
+
+
+//
+// 'main()' - Main entry.
+//
+
+int					// O - Exit status
+main(int  argc,				// I - Number of command-line arguments
+     char *argv[])			// I - Command-line arguments
+{
+  int		i;			// Looping var
+  double	ggamma = 0.4545,	// Graphics gamma
+		pgamma = 0.4545;	// Photo gamma
+  const char	*matrix = NULL;		// Alternate matrix file
+
+
+  for (i = 1; i < argc; i ++)
+  {
+    if (!strcmp(argv[i], "--help"))
+    {
+      return (usage(stdout));
+    }
+    else if (!strcmp(argv[i], "-g") || !strcmp(argv[i], "-p"))
+    {
+      double	gamma;			// Gamma value
+
+      if ((i + 1) >= argc || (gamma = strtod(argv[i + 1], NULL)) <= 0.0)
+      {
+        fprintf(stderr, "makedither: Expected gamma after '%s'.\n", argv[i]);
+        return (usage(stderr));
+      }
+
+      if (argv[i][1] == 'g')
+        ggamma = gamma;
+      else
+        pgamma = gamma;
+
+      i ++;
+    }
+    else if (!strcmp(argv[i], "-m"))
+    {
+      i ++;
+      if (i >= argc)
+      {
+        fputs("makedither: Expected filename after '-m'.\n", stderr);
+        return (usage(stderr));
+      }
+
+      matrix = argv[i];
+    }
+    else
+    {
+      fprintf(stderr, "makedither: Unknown option '%s'.\n", argv[i]);
+      return (usage(stderr));
+    }
+  }
+
+  if (matrix && read_matrix(matrix))
+    return (1);
+
+  printf("//\n");
+  printf("// Gamma-corrected dither matrices for cupslocald.\n");
+  printf("//\n");
+  printf("// This file is generated by \"makedither\" - do not edit.\n");
+  printf("//\n");
+  printf("// Graphics gamma %.4f, photo gamma %.4f, %s matrix.\n", ggamma, pgamma, matrix ? matrix : "default");
+  printf("//\n\n");
+
+  write_matrix("local_gdither", ggamma);
+  putchar('\n');
+  write_matrix("local_pdither", pgamma);
+
+  return (0);
+}
+
+
+//
+// 'read_matrix()' - Read an alternate 16x16 dither matrix.
+//
+
+static int				// O - 0 on success, 1 on error
+read_matrix(const char *filename)	// I - Matrix file
+{
+  FILE	*fp;				// Matrix file
+  int	i,				// Looping var
+	value;				// Matrix value
+
+
+  if ((fp = fopen(filename, "r")) == NULL)
+  {
+    perror(filename);
+    return (1);
+  }
+
+  for (i = 0; i < 256; i ++)
+  {
+    if (fscanf(fp, "%d", &value) != 1 || value < 0 || value > 255)
+    {
+      fprintf(stderr, "makedither: %s: Expected 256 values from 0 to 255.\n", filename);
+      fclose(fp);
+      return (1);
+    }
+
+    dither[i / 16][i % 16] = (unsigned char)value;
+  }
+
+  fclose(fp);
+
+  return (0);
+}
+
+
+//
+// 'usage()' - Show program usage.
+//
+
+static int				// O - Exit status
+usage(FILE *fp)				// I - Output file
+{
+  fputs("Usage: makedither [OPTIONS] >dither.h\n", fp);
+  fputs("Options:\n", fp);
+  fputs("--help                         Show this help\n", fp);
+  fputs("-g GAMMA                       Set the graphics gamma (default 0.4545)\n", fp);
+  fputs("-m FILENAME                    Use an alternate 16x16 dither matrix\n", fp);
+  fputs("-p GAMMA                       Set the photo gamma (default 0.4545)\n", fp);
+
+  return (fp == stdout ? 0 : 1);
+}
+
+
+//
+// 'write_matrix()' - Write a gamma-corrected dither matrix.
+//
+
+static void
+write_matrix(const char *name,		// I - Variable name
+             double     gamma)		// I - Gamma correction
+{
+  int	i, j;				// Looping vars
+
+
+  printf("static const unsigned char %s[16][16] =\n{\n", name);
+
+  for (i = 0; i < 16; i ++)
+  {
+    fputs("  {", stdout);
+
+    for (j = 0; j < 16; j ++)
+      printf(" %3d%s", 255 - (int)(255.0 * pow(1.0 - dither[i][j] / 255.0, gamma)), j < 15 ? "," : " ");
+
+    printf("}%s\n", i < 15 ? "," : "");
+  }
+
+  puts("};");
+}
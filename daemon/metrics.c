@@ -0,0 +1,208 @@
+//
+// Metrics for cupslocald.
+//
+// The metrics are served as "/metrics" in the Prometheus text format.  Each
+// metric is a summary with the number of observations and their sum, except
+// for the queue depth which is reported for each printer when requested.
+//
+// Copyright © 2025 by OpenPrinting.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+#include "cupslocald.h"
+#include <cups/thread.h>
+#include <stdarg.h>
+
+
+//
+// Local types...
+//
+
+typedef struct local_mdata_s		// Metric data
+{
+  const char	*name,			// Metric name
+		*labels,		// Labels or `NULL`
+		*help;			// Help text
+  size_t	count;			// Number of observations
+  double	sum;			// Sum of observations
+} local_mdata_t;
+
+
+//
+// Local globals...
+//
+
+static local_mdata_t	metrics[LOCAL_METRIC_MAX] =
+{					// Metrics, in local_metric_t order
+  { "cupslocald_device_write_seconds", NULL, "Time spent writing to printer devices.", 0, 0.0 },
+  { "cupslocald_document_bytes", NULL, "Bytes sent to the printer for each document.", 0, 0.0 },
+  { "cupslocald_page_render_seconds", "driver=\"pcl\"", "Time to render a raster page in the driver.", 0, 0.0 },
+  { "cupslocald_page_render_seconds", "driver=\"ps\"", "Time to render a raster page in the driver.", 0, 0.0 },
+  { "cupslocald_pcl_raster_bytes", "stage=\"input\"", "PCL raster bytes for each page before and after compression.", 0, 0.0 },
+  { "cupslocald_pcl_raster_bytes", "stage=\"output\"", "PCL raster bytes for each page before and after compression.", 0, 0.0 },
+  { "cupslocald_probe_seconds", NULL, "Time to get the capabilities of an IPP Everywhere printer.", 0, 0.0 },
+  { "cupslocald_transform_cache_bytes", "result=\"hit\"", "Transform output bytes sent from or saved to the cache.", 0, 0.0 },
+  { "cupslocald_transform_cache_bytes", "result=\"store\"", "Transform output bytes sent from or saved to the cache.", 0, 0.0 },
+  { "cupslocald_transform_spawn_seconds", NULL, "Time to start an ipptransform command.", 0, 0.0 },
+  { "cupslocald_transform_seconds", NULL, "Time from starting an ipptransform command to its exit.", 0, 0.0 },
+  { "cupslocald_transform_wait_seconds", NULL, "Time a document waited for a free transform slot.", 0, 0.0 }
+};
+static cups_mutex_t	metrics_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for metrics
+
+
+//
+// Local functions...
+//
+
+static void	metrics_printf(http_t *http, const char *format, ...) _CUPS_FORMAT(2, 3);
+static void	metrics_queue(pappl_printer_t *printer, http_t *http);
+
+
+//
+// 'LocalMetricsAdd()' - Add observations to a metric.
+//
+
+void
+LocalMetricsAdd(local_metric_t metric,	// I - Metric
+                size_t         count,	// I - Number of observations
+                double         sum)	// I - Sum of observations
+{
+  if (metric < LOCAL_METRIC_DEVICE_WRITE || metric >= LOCAL_METRIC_MAX || count == 0)
+    return;
+
+  cupsMutexLock(&metrics_mutex);
+  metrics[metric].count += count;
+  metrics[metric].sum   += sum;
+  cupsMutexUnlock(&metrics_mutex);
+}
+
+
+//
+// 'LocalMetricsAddDevice()' - Add the device writes since "start".
+//
+// "start" holds the device metrics from the start of the document, so that
+// only the writes for this document are counted.
+//
+
+void
+LocalMetricsAddDevice(
+    pappl_device_t     *device,		// I - Device
+    pappl_devmetrics_t *start)		// I - Device metrics at start of document
+{
+  pappl_devmetrics_t	current;	// Current device metrics
+
+
+  papplDeviceGetMetrics(device, &current);
+
+  LocalMetricsAdd(LOCAL_METRIC_DEVICE_WRITE, current.write_requests - start->write_requests, (current.write_msecs - start->write_msecs) * 0.001);
+  LocalMetricsAdd(LOCAL_METRIC_JOB_BYTES, 1, (double)(current.write_bytes - start->write_bytes));
+}
+
+
+//
+// 'LocalMetricsCallback()' - Send the current metrics to a client.
+//
+
+bool					// O - `true` on success, `false` on failure
+LocalMetricsCallback(
+    pappl_client_t *client,		// I - Client
+    pappl_system_t *system)		// I - System
+{
+  http_t		*http = papplClientGetHTTP(client);
+					// HTTP connection
+  local_mdata_t		current[LOCAL_METRIC_MAX];
+					// Copy of metrics
+  local_metric_t	i;		// Looping var
+
+
+  // Copy the metrics so the lock isn't held while writing to the client...
+  cupsMutexLock(&metrics_mutex);
+  memcpy(current, metrics, sizeof(current));
+  cupsMutexUnlock(&metrics_mutex);
+
+  if (!papplClientRespond(client, HTTP_STATUS_OK, /*content_encoding*/NULL, "text/plain; version=0.0.4", /*last_modified*/0, /*length*/0))
+    return (false);
+
+  for (i = LOCAL_METRIC_DEVICE_WRITE; i < LOCAL_METRIC_MAX; i ++)
+  {
+    // Only show the help and type once for each name...
+    if (i == LOCAL_METRIC_DEVICE_WRITE || strcmp(current[i].name, current[i - 1].name))
+      metrics_printf(http, "# HELP %s %s\n# TYPE %s summary\n", current[i].name, current[i].help, current[i].name);
+
+    if (current[i].labels)
+      metrics_printf(http, "%s_count{%s} %lu\n%s_sum{%s} %g\n", current[i].name, current[i].labels, (unsigned long)current[i].count, current[i].name, current[i].labels, current[i].sum);
+    else
+      metrics_printf(http, "%s_count %lu\n%s_sum %g\n", current[i].name, (unsigned long)current[i].count, current[i].name, current[i].sum);
+  }
+
+  metrics_printf(http, "# HELP cupslocald_queue_depth Number of active jobs for each printer.\n# TYPE cupslocald_queue_depth gauge\n");
+  papplSystemIteratePrinters(system, (pappl_printer_cb_t)metrics_queue, http);
+
+  httpWrite(http, "", 0);
+
+  return (true);
+}
+
+
+//
+// 'metrics_printf()' - Send formatted text to the client.
+//
+
+static void
+metrics_printf(http_t     *http,	// I - HTTP connection
+               const char *format,	// I - Printf-style format string
+               ...)			// I - Additional arguments as needed
+{
+  va_list	ap;			// Pointer to arguments
+  char		buffer[1024];		// Output buffer
+  int		bytes;			// Length of output
+
+
+  va_start(ap, format);
+  bytes = vsnprintf(buffer, sizeof(buffer), format, ap);
+  va_end(ap);
+
+  if (bytes > 0)
+    httpWrite(http, buffer, (size_t)bytes < sizeof(buffer) ? (size_t)bytes : sizeof(buffer) - 1);
+}
+
+
+//
+// 'metrics_queue()' - Send the queue depth for a printer.
+//
+
+static void
+metrics_queue(pappl_printer_t *printer,	// I - Printer
+              http_t          *http)	// I - HTTP connection
+{
+  const char	*name;			// Printer name
+  char		label[256],		// Quoted printer name
+		*ptr;			// Pointer into label
+
+
+  // Escape backslashes, quotes, and newlines in the name...
+  for (name = papplPrinterGetName(printer), ptr = label; *name && ptr < (label + sizeof(label) - 2); name ++)
+  {
+    if (*name == '\\' || *name == '\"')
+    {
+      *ptr++ = '\\';
+      *ptr++ = *name;
+    }
+    else if (*name == '\n')
+    {
+      *ptr++ = '\\';
+      *ptr++ = 'n';
+    }
+    else
+    {
+      *ptr++ = *name;
+    }
+  }
+
+  *ptr = '\0';
+
+  metrics_printf(http, "cupslocald_queue_depth{printer=\"%s\"} %d\n", label, papplPrinterGetNumberOfActiveJobs(printer));
+}
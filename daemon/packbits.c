@@ -0,0 +1,152 @@
+//
+// PackBits compression for cupslocald.
+//
+// Copyright © 2025 by OpenPrinting.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+#include "cupslocald.h"
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#  define LOCAL_PACKBITS_WORDS 1
+#endif // __GNUC__ && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+
+
+//
+// Local functions...
+//
+
+static size_t	packbits_literal(const unsigned char *ptr, size_t limit);
+static size_t	packbits_run(const unsigned char *ptr, size_t limit);
+
+
+//
+// 'LocalPackBits()' - Compress a line using TIFF PackBits compression.
+//
+// The destination buffer must hold `2 * length + 2` bytes, since runs of 2
+// bytes between single literal bytes expand the data.
+//
+// Run boundaries are found 8 bytes at a time, but the output is the same as
+// a simple byte-at-a-time encoder: runs of 2 or more bytes are repeated, and
+// a single byte at the end of a literal sequence is sent on its own.
+//
+
+size_t					// O - Length of compressed data
+LocalPackBits(
+    unsigned char       *dst,		// I - Destination buffer
+    const unsigned char *src,		// I - Line to compress
+    size_t              length)		// I - Number of bytes
+{
+  const unsigned char	*src_ptr,	// Current byte pointer
+			*src_end;	// End-of-line byte pointer
+  unsigned char		*dst_ptr;	// Pointer into destination buffer
+  size_t		count,		// Count of bytes for output
+			limit;		// Maximum count
+
+
+  for (src_ptr = src, src_end = src + length, dst_ptr = dst; src_ptr < src_end; src_ptr += count)
+  {
+    if ((src_ptr + 1) >= src_end)
+    {
+      // Single byte on the end...
+      count      = 1;
+      *dst_ptr++ = 0x00;
+      *dst_ptr++ = *src_ptr;
+    }
+    else if (src_ptr[0] == src_ptr[1])
+    {
+      // Repeated sequence...
+      if ((limit = (size_t)(src_end - src_ptr)) > 128)
+        limit = 128;
+
+      count      = packbits_run(src_ptr, limit);
+      *dst_ptr++ = (unsigned char)(257 - count);
+      *dst_ptr++ = *src_ptr;
+    }
+    else
+    {
+      // Non-repeated sequence, leaving the last byte for the next pass...
+      if ((limit = (size_t)(src_end - src_ptr - 1)) > 128)
+        limit = 128;
+
+      count      = packbits_literal(src_ptr, limit);
+      *dst_ptr++ = (unsigned char)(count - 1);
+
+      memcpy(dst_ptr, src_ptr, count);
+      dst_ptr += count;
+    }
+  }
+
+  return ((size_t)(dst_ptr - dst));
+}
+
+
+//
+// 'packbits_literal()' - Find the length of a non-repeated sequence.
+//
+// Returns the offset of the first byte that starts a repeated sequence, or
+// "limit" if there is none.  "ptr[limit]" must be a valid byte.
+//
+
+static size_t				// O - Length of sequence
+packbits_literal(
+    const unsigned char *ptr,		// I - Start of sequence
+    size_t              limit)		// I - Maximum length
+{
+  size_t	i = 1;			// Current offset
+#ifdef LOCAL_PACKBITS_WORDS
+  uint64_t	a, b,			// Current and next bytes
+		zeros;			// Bytes that match
+
+
+  for (; (i + 8) <= limit; i += 8)
+  {
+    // XOR each byte with the next one, then look for a zero byte; borrows
+    // only give false matches above the first real one...
+    memcpy(&a, ptr + i, sizeof(a));
+    memcpy(&b, ptr + i + 1, sizeof(b));
+
+    a ^= b;
+    if ((zeros = (a - 0x0101010101010101ULL) & ~a & 0x8080808080808080ULL) != 0)
+      return (i + (size_t)__builtin_ctzll(zeros) / 8);
+  }
+#endif // LOCAL_PACKBITS_WORDS
+
+  while (i < limit && ptr[i] != ptr[i + 1])
+    i ++;
+
+  return (i);
+}
+
+
+//
+// 'packbits_run()' - Find the length of a repeated sequence.
+//
+
+static size_t				// O - Length of sequence
+packbits_run(
+    const unsigned char *ptr,		// I - Start of sequence
+    size_t              limit)		// I - Maximum length
+{
+  size_t	i = 2;			// Current offset
+#ifdef LOCAL_PACKBITS_WORDS
+  uint64_t	pattern = ptr[0] * 0x0101010101010101ULL,
+					// Repeated byte
+		word;			// Current bytes
+
+
+  for (; (i + 8) <= limit; i += 8)
+  {
+    memcpy(&word, ptr + i, sizeof(word));
+
+    if ((word ^= pattern) != 0)
+      return (i + (size_t)__builtin_ctzll(word) / 8);
+  }
+#endif // LOCAL_PACKBITS_WORDS
+
+  while (i < limit && ptr[i] == ptr[0])
+    i ++;
+
+  return (i);
+}
@@ -0,0 +1,292 @@
+//
+// Driver unit tests for cupslocald.
+//
+// Usage:
+//
+//   ./testdrivers
+//
+// The driver and dithering sources are included so that their static
+// functions can be tested without a printer.
+//
+// Copyright © 2025 by OpenPrinting.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+#define CUPSLOCALD_MAIN_C
+#include "drivers.c"
+#include "dither.c"
+
+
+//
+// Local types...
+//
+
+typedef unsigned (*test_kernel_t)(unsigned char *dst, const unsigned char *src, unsigned width, const unsigned char *drow, bool black);
+					// Dither kernel
+
+
+//
+// Local functions...
+//
+
+static bool	test_caps(const char *name, pappl_pr_driver_data_t *data, ipp_t *response, const char *format, size_t num_resolution, const int *resolutions, pappl_finishings_t finishings);
+static bool	test_dither(const char *name, test_kernel_t kernel);
+static ipp_t	*urf_attributes(bool staple);
+
+
+//
+// 'main()' - Main entry.
+//
+
+int					// O - Exit status
+main(void)
+{
+  pappl_pr_driver_data_t data;		// Printer driver data
+  int			status = 0;	// Exit status
+  static const int	generic[] = { 300 };
+					// Generic resolutions
+  static const int	urf[] = { 300, 600 };
+					// URF resolutions
+
+
+  // A printer that was added with generic capabilities...
+  memset(&data, 0, sizeof(data));
+
+  if (!test_caps("generic", &data, eve_default_attributes(), "image/pwg-raster", 1, generic, PAPPL_FINISHINGS_NONE))
+    status = 1;
+
+  // ... then gets the printer's capabilities from a late probe...
+  if (!test_caps("generic+urf", &data, urf_attributes(true), "image/urf", 2, urf, PAPPL_FINISHINGS_STAPLE))
+    status = 1;
+
+  // ... and later revalidations with and without changes...
+  if (!test_caps("urf+urf", &data, urf_attributes(true), "image/urf", 2, urf, PAPPL_FINISHINGS_STAPLE))
+    status = 1;
+
+  if (!test_caps("urf+nostaple", &data, urf_attributes(false), "image/urf", 2, urf, PAPPL_FINISHINGS_NONE))
+    status = 1;
+
+  if (!test_caps("urf+generic", &data, eve_default_attributes(), "image/pwg-raster", 1, generic, PAPPL_FINISHINGS_NONE))
+    status = 1;
+
+  // Compare each dither kernel, and LocalDitherLine itself, with the scalar
+  // code...
+#ifdef LOCAL_DITHER_X86
+  if (__builtin_cpu_supports("avx2") && !test_dither("dither-avx2", dither_avx2))
+    status = 1;
+
+  if (!test_dither("dither-sse2", dither_sse2))
+    status = 1;
+#elif defined(LOCAL_DITHER_NEON)
+  if (!test_dither("dither-neon", dither_neon))
+    status = 1;
+#endif // LOCAL_DITHER_X86
+
+  if (!test_dither("dither-line", NULL))
+    status = 1;
+
+  return (status);
+}
+
+
+//
+// 'test_caps()' - Copy capabilities to the driver data and check the result.
+//
+
+static bool				// O - `true` on success, `false` on failure
+test_caps(
+    const char             *name,	// I - Test name
+    pappl_pr_driver_data_t *data,	// I - Printer driver data
+    ipp_t                  *response,	// I - Printer attributes
+    const char             *format,	// I - Expected format
+    size_t                 num_resolution,
+					// I - Expected number of resolutions
+    const int              *resolutions,// I - Expected resolutions
+    pappl_finishings_t     finishings)	// I - Expected finishings
+{
+  size_t	i;			// Looping var
+  bool		ret = true;		// Return value
+
+
+  printf("%-16s ", name);
+
+  eve_copy_capabilities(data, response);
+  ippDelete(response);
+
+  if (!data->format || strcmp(data->format, format))
+  {
+    printf("FAIL (format is '%s', expected '%s')\n", data->format ? data->format : "(null)", format);
+    ret = false;
+  }
+  else if (data->num_resolution != num_resolution)
+  {
+    printf("FAIL (%lu resolutions, expected %lu)\n", (unsigned long)data->num_resolution, (unsigned long)num_resolution);
+    ret = false;
+  }
+  else if (data->finishings_supported != finishings)
+  {
+    printf("FAIL (finishings are 0x%x, expected 0x%x)\n", (unsigned)data->finishings_supported, (unsigned)finishings);
+    ret = false;
+  }
+  else
+  {
+    for (i = 0; i < num_resolution && ret; i ++)
+    {
+      if (data->x_resolution[i] != resolutions[i] || data->y_resolution[i] != resolutions[i])
+      {
+        printf("FAIL (resolution %lu is %dx%ddpi, expected %ddpi)\n", (unsigned long)i, data->x_resolution[i], data->y_resolution[i], resolutions[i]);
+        ret = false;
+      }
+    }
+
+    for (i = 0; i < num_resolution && ret; i ++)
+    {
+      if (data->x_default == resolutions[i] && data->y_default == resolutions[i])
+        break;
+    }
+
+    if (ret && i >= num_resolution)
+    {
+      printf("FAIL (default resolution %dx%ddpi is not supported)\n", data->x_default, data->y_default);
+      ret = false;
+    }
+  }
+
+  if (ret)
+    puts("PASS");
+
+  return (ret);
+}
+
+
+//
+// 'test_dither()' - Compare a dither kernel with the scalar code.
+//
+// Random lines are dithered with random widths, offsets, and dither values,
+// using pixels that are often equal to the dither value.  When "kernel" is
+// `NULL`, LocalDitherLine is tested instead.
+//
+
+static bool				// O - `true` on success, `false` on failure
+test_dither(const char    *name,	// I - Test name
+            test_kernel_t kernel)	// I - Kernel or `NULL` for LocalDitherLine
+{
+  int		i;			// Looping var
+  unsigned	x,			// Current column
+		width,			// Width of line
+		offset,			// Column of first pixel
+		count,			// Number of pixels dithered
+		bytes,			// Number of bytes to compare
+		seed = 1;		// Random number seed
+  bool		black;			// Black or gray pixels?
+  unsigned char	dither[16],		// Dither row
+		drow[32],		// Aligned dither row
+		src[512],		// Source pixels
+		dst[66],		// Kernel output
+		ref[66];		// Scalar output
+
+
+  printf("%-16s ", name);
+
+  for (i = 0; i < 10000; i ++)
+  {
+    seed   = seed * 1103515245 + 12345;
+    width  = (seed >> 16) % (sizeof(src) + 1);
+    seed   = seed * 1103515245 + 12345;
+    offset = (seed >> 16) & 15;
+    black  = (seed >> 20) & 1;
+
+    for (x = 0; x < 16; x ++)
+    {
+      seed      = seed * 1103515245 + 12345;
+      dither[x] = (unsigned char)(seed >> 16);
+    }
+
+    for (x = 0; x < 32; x ++)
+      drow[x] = dither[(offset + x) & 15];
+
+    for (x = 0; x < width; x ++)
+    {
+      // Use the dither value and its neighbors half of the time...
+      seed = seed * 1103515245 + 12345;
+      if ((seed >> 24) & 1)
+        src[x] = (unsigned char)(drow[x & 15] + (int)((seed >> 16) % 3) - 1);
+      else
+        src[x] = (unsigned char)(seed >> 16);
+    }
+
+    memset(dst, 0xa5, sizeof(dst));
+    memset(ref, 0xa5, sizeof(ref));
+
+    dither_scalar(ref, src, width, drow, black);
+
+    if (kernel)
+    {
+      // Kernels only do whole bytes and must not touch the rest...
+      if ((count = (kernel)(dst, src, width, drow, black)) > width || (count & 7))
+      {
+        printf("FAIL (dithered %u of %u pixels)\n", count, width);
+        return (false);
+      }
+
+      bytes = count / 8;
+      if (dst[bytes] != 0xa5)
+      {
+        printf("FAIL (wrote past %u pixels with width %u)\n", count, width);
+        return (false);
+      }
+    }
+    else
+    {
+      LocalDitherLine(dst, src, width, dither, offset, black);
+      bytes = (width + 7) / 8 + 1;
+    }
+
+    if (memcmp(dst, ref, bytes))
+    {
+      for (x = 0; x < bytes && dst[x] == ref[x]; x ++);
+
+      printf("FAIL (width %u, offset %u, %s, byte %u is 0x%02x, expected 0x%02x)\n", width, offset, black ? "black" : "gray", x, dst[x], ref[x]);
+      return (false);
+    }
+  }
+
+  puts("PASS");
+
+  return (true);
+}
+
+
+//
+// 'urf_attributes()' - Make attributes for an AirPrint printer.
+//
+
+static ipp_t *				// O - Printer attributes
+urf_attributes(bool staple)		// I - Report stapling?
+{
+  ipp_t		*response = ippNew();	// Printer attributes
+  static const char * const formats[] =	// document-format-supported values
+  {
+    "image/jpeg",
+    "image/urf"
+  };
+  static const char * const urf[] =	// urf-supported values
+  {
+    "CP1",
+    "RS300-600",
+    "SRGB24",
+    "W8"
+  };
+
+
+  ippAddString(response, IPP_TAG_PRINTER, IPP_TAG_TEXT, "printer-make-and-model", NULL, "Example AirPrint Printer");
+  ippAddStrings(response, IPP_TAG_PRINTER, IPP_TAG_MIMETYPE, "document-format-supported", sizeof(formats) / sizeof(formats[0]), NULL, formats);
+  ippAddStrings(response, IPP_TAG_PRINTER, IPP_TAG_KEYWORD, "urf-supported", sizeof(urf) / sizeof(urf[0]), NULL, urf);
+
+  if (staple)
+    ippAddInteger(response, IPP_TAG_PRINTER, IPP_TAG_ENUM, "finishings-supported", IPP_FINISHINGS_STAPLE);
+
+  return (response);
+}
@@ -1,24 +1,139 @@
 //
 // Transform support for cupslocald.
 //
-// Copyright © 2023-2025 by OpenPrinting.
+// Copyright © 2023-2025 by OpenPrinting.
 //
 // Licensed under Apache License v2.0.  See the file "LICENSE" for more
 // information.
 //
 
 #include "cupslocald.h"
+#include <cups/thread.h>
+#include <dirent.h>
 #include <poll.h>
 #include <spawn.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/wait.h>
 extern char **environ;
 
 
+//
+// Local constants...
+//
+
+#define LOCAL_MAX_WORKERS	16	// Maximum number of transform workers
+#define LOCAL_XPIPE_SIZE	1048576	// Size of transform output pipe
+#define LOCAL_XMSG_MAX		65536	// Maximum size of worker request data
+#define LOCAL_XENV_MAX		1000	// Maximum number of transform environment variables
+#define LOCAL_XCACHE_MAGIC	"CLXCACHE"
+					// Magic string for transform cache files
+#define LOCAL_XCACHE_STALE	600	// Seconds before an unchanged temporary cache file is removed
+#define LOCAL_XSCHED_AGE	30.0	// Seconds before a waiting transform goes ahead of smaller ones
+
+
+//
+// Local types...
+//
+
+typedef struct local_worker_s		// Transform worker process
+{
+  pid_t		pid;			// Process ID or 0 if not running
+  int		fd;			// Control socket
+  bool		busy;			// Running a transform?
+  time_t	last_used;		// Last time the worker was used
+} local_worker_t;
+
+typedef struct local_xcache_s		// Transform cache file header
+{
+  char		magic[8];		// LOCAL_XCACHE_MAGIC
+  int		impressions;		// Number of impressions
+} local_xcache_t;
+
+typedef struct local_xcentry_s		// Transform cache entry for eviction
+{
+  char		*filename;		// Cache filename
+  off_t		size;			// Size in bytes
+  time_t	mtime;			// Last use time
+} local_xcentry_t;
+
+typedef struct local_xenv_s		// Printer environment for transforms
+{
+  struct local_xenv_s *next;		// Next printer environment
+  int		printer_id,		// Printer ID
+		config_changes;		// System configuration changes when built
+  size_t	use;			// Number of transforms using the environment
+  bool		stale;			// Free when no longer used?
+  size_t	envc;			// Number of environment variables
+  char		**envp;			// Environment variables
+} local_xenv_t;
+
+typedef struct local_xmsg_s		// Transform worker request header
+{
+  size_t	argc,			// Number of arguments
+		envc,			// Number of environment variables
+		length;			// Length of string data
+} local_xmsg_t;
+
+typedef struct local_xwait_s		// Transform waiting for a slot
+{
+  struct local_xwait_s *next;		// Next waiting transform
+  int		priority;		// Job priority
+  off_t		size;			// Document size in bytes
+  double	queued;			// Time when queued
+} local_xwait_t;
+
+
+//
+// Local globals...
+//
+
+static cups_mutex_t	worker_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for worker pool
+static local_worker_t	workers[LOCAL_MAX_WORKERS];
+					// Worker pool
+static cups_mutex_t	xcache_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for transform cache eviction
+static local_xenv_t	*xenv_list = NULL;
+					// Printer environments
+static cups_mutex_t	xenv_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for printer environments
+static cups_cond_t	xsched_cond = CUPS_COND_INITIALIZER;
+					// Condition for transform slots
+static cups_mutex_t	xsched_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for transform slots
+static size_t		xsched_running = 0;
+					// Number of running transforms
+static local_xwait_t	*xsched_waiting = NULL;
+					// Transforms waiting for a slot
+
+
 //
 // Local functions...
 //
 
-static void	process_attr_message(pappl_job_t *job, char *message);
+static void	process_attr_message(pappl_job_t *job, char *message, int *impressions);
+static bool	read_all(int fd, void *buffer, size_t bytes);
+static local_worker_t *worker_acquire(pappl_job_t *job);
+static void	worker_expire(time_t curtime);
+static void	worker_main(int fd) _CUPS_NORETURN;
+static void	worker_release(local_worker_t *worker, bool stop);
+static pid_t	worker_spawn(local_worker_t *worker, const char * const *argv, size_t envc, char * const *envp, int fds[3]);
+static void	worker_stop(local_worker_t *worker);
+static bool	write_all(int fd, const void *buffer, size_t bytes);
+static int	xcache_compare(local_xcentry_t *a, local_xcentry_t *b);
+static void	xcache_evict(void);
+static bool	xcache_key(pappl_job_t *job, int doc_number, size_t envc, char * const *envp, char *filename, size_t filesize);
+static int	xcache_open(const char *filename, int *impressions);
+static bool	xcache_send(pappl_job_t *job, pappl_device_t *device, int fd, int impressions);
+static local_xenv_t *xenv_acquire(pappl_printer_t *printer);
+static local_xenv_t *xenv_create(pappl_printer_t *printer, int config_changes);
+static void	xenv_release(local_xenv_t *env);
+static void	xenv_string(ipp_attribute_t *attr, char *buffer, size_t bufsize);
+static bool	xsched_acquire(pappl_job_t *job, int doc_number);
+static bool	xsched_before(local_xwait_t *a, local_xwait_t *b, double curtime);
+static void	xsched_release(void);
 
 
 //
@@ -34,25 +149,44 @@ LocalTransformFilter(
     void               *cbdata)		// I - Callback data (not used)
 {
   size_t		i;		// Looping var
-  pappl_printer_t	*printer;	// Printer for job
-  pappl_pr_driver_data_t pdata;		// Printer driver data
-  ipp_t			*pattrs;	// Printer driver attributes
   ipp_attribute_t	*attr;		// Current attribute
   const char 		*xargv[3];	// Command-line arguments for ipptransform
-  size_t		xenvc;		// Number of environment variables
-  char			*xenvp[1000];	// Environment variables for ipptransform
-  pid_t			xpid;		// Process ID for ipptransform program
-  int			xstdout[2] = {-1,-1},
+  local_xenv_t		*penv;		// Printer environment
+  size_t		xenvc = 0;	// Number of environment variables
+  char			*xenvp[LOCAL_XENV_MAX];
+					// Environment variables for ipptransform
+  local_worker_t	*worker;	// Transform worker, if any
+  pid_t			xpid = 0;	// Process ID for ipptransform program
+  int			xstdin = -1,	// Standard input for ipptransform
+			xstdout[2] = {-1,-1},
 					// Standard output pipe for ipptransform
 			xstderr[2] = {-1,-1},
 					// Standard error pipe for ipptransform
-			xstatus;	// Exit status of ipptransform
-  posix_spawn_file_actions_t xactions;	// File actions
+			xfds[3],	// Standard I/O for ipptransform
+			xstatus,	// Exit status of ipptransform
+			cachefd = -1,	// Transform cache file
+			impressions = 0;// Number of impressions
+  bool			canceled = false,
+					// Was the job canceled?
+			scheduled = false,
+					// Do we have a transform slot?
+			write_error = false;
+					// Did a device write fail?
   struct pollfd		polldata[2];	// poll() file descriptors
   ssize_t		bytes;		// Number of bytes read
+  char			*data = NULL;	// Data from stdout
+  size_t		datasize = 65536,
+					// Size of data buffer
+			total = 0;	// Total bytes sent to device
+  char			cachefile[1024],
+					// Transform cache filename
+			cachetemp[1024];
+					// Temporary transform cache filename
+  double		start,		// Start time
+			spawn_start;	// Time when starting the transform
+  pappl_devmetrics_t	devmetrics;	// Device metrics at start
   char			val[1280],	// IPP_NAME=value
 			*valptr,	// Pointer into string
-			data[32768],	// Data from stdout
 			line[2048],	// Line from stderr
 			*ptr,		// Pointer into line
 			*endptr;	// End of line
@@ -101,10 +235,12 @@ LocalTransformFilter(
 
   (void)cbdata;
 
-  // Get job and printer information...
-  printer = papplJobGetPrinter(job);
-  pattrs  = papplPrinterGetDriverAttributes(printer);
-  papplPrinterGetDriverData(printer, &pdata);
+  // Get the printer environment...
+  if ((penv = xenv_acquire(papplJobGetPrinter(job))) == NULL)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for transform environment: %s", strerror(errno));
+    return (false);
+  }
 
   papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Running ipptransform command.");
 
@@ -113,85 +249,25 @@ LocalTransformFilter(
   xargv[1] = papplJobGetDocumentFilename(job, doc_number);
   xargv[2] = NULL;
 
-  // Copy the current environment, then add environment variables for every
-  // Job attribute and select Printer attributes...
-  for (xenvc = 0; environ[xenvc] && xenvc < (sizeof(xenvp) / sizeof(xenvp[0]) - 1); xenvc ++)
-    xenvp[xenvc] = strdup(environ[xenvc]);
-
-  if (xenvc > (sizeof(xenvp) / sizeof(xenvp[0]) - 32))
-  {
-    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Too many environment variables to transform job.");
-    goto transform_failure;
-  }
+  // Add environment variables for select Printer attributes, then every Job
+  // attribute - the current environment is inherited by the worker or added
+  // when spawning the command directly.  The printer variables are shared, so
+  // only the job variables are freed...
+  memcpy(xenvp, penv->envp, penv->envc * sizeof(char *));
+  xenvc = penv->envc;
 
   if (asprintf(xenvp + xenvc, "CONTENT_TYPE=%s", papplJobGetDocumentFormat(job, doc_number)) > 0)
     xenvc ++;
 
-  if (pdata.format && asprintf(xenvp + xenvc, "OUTPUT_TYPE=%s", pdata.format) > 0)
-    xenvc ++;
-
-  for (attr = ippGetFirstAttribute(pattrs); attr && xenvc < (sizeof(xenvp) / sizeof(xenvp[0]) - 1); attr = ippGetNextAttribute(pattrs))
-  {
-    // Convert "attribute-name-default" to "IPP_ATTRIBUTE_NAME_DEFAULT=" and
-    // "pwg-xxx" to "IPP_PWG_XXX=", then add the value(s) from the attribute.
-    const char	*name = ippGetName(attr);
-					// Attribute name
-
-    if (strncmp(name, "pwg-", 4) && !strstr(name, "-default"))
-      continue;
-
-    valptr = val;
-    *valptr++ = 'I';
-    *valptr++ = 'P';
-    *valptr++ = 'P';
-    *valptr++ = '_';
-    while (*name && valptr < (val + sizeof(val) - 2))
-    {
-      if (*name == '-')
-	*valptr++ = '_';
-      else
-	*valptr++ = (char)toupper(*name & 255);
-
-      name ++;
-    }
-    *valptr++ = '=';
-    ippAttributeString(attr, valptr, sizeof(val) - (size_t)(valptr - val));
-
-    xenvp[xenvc++] = strdup(val);
-  }
-
-  xenvp[xenvc ++] = strdup("SERVER_LOGLEVEL=debug");
-
   for (i = 0; i < (sizeof(jattrs) / sizeof(jattrs[0])) && xenvc < (sizeof(xenvp) / sizeof(xenvp[0]) - 1); i ++)
   {
-    // Convert "attribute-name" to "IPP_ATTRIBUTE_NAME=" and then add the
-    // value(s) from the attribute.
-    const char *name;			// Attribute name
-
     if ((attr = papplJobGetDocumentAttribute(job, doc_number, jattrs[i])) == NULL)
     {
       if ((attr = papplJobGetAttribute(job, jattrs[i])) == NULL)
         continue;
     }
 
-    name   = ippGetName(attr);
-    valptr = val;
-    *valptr++ = 'I';
-    *valptr++ = 'P';
-    *valptr++ = 'P';
-    *valptr++ = '_';
-    while (*name && valptr < (val + sizeof(val) - 2))
-    {
-      if (*name == '-')
-        *valptr++ = '_';
-      else
-        *valptr++ = (char)toupper(*name & 255);
-
-      name ++;
-    }
-    *valptr++ = '=';
-    ippAttributeString(attr, valptr, sizeof(val) - (size_t)(valptr - val));
-
+    xenv_string(attr, val, sizeof(val));
     xenvp[xenvc++] = strdup(val);
   }
 
@@ -201,41 +277,161 @@ LocalTransformFilter(
   for (i = 0; i < xenvc; i ++)
     papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "    %s", xenvp[i]);
 
-  // Now run the program...
+  // Wait for a transform slot so that busy printers don't oversubscribe the
+  // CPU.  Hashing the document for the cache counts against the limit, too...
+  if (!xsched_acquire(job, doc_number))
+    goto transform_failure;
+
+  scheduled = true;
+
+  // Send the cached output when the same document has been transformed with
+  // the same options...
+  if (LocalTransformCache > 0 && xcache_key(job, doc_number, xenvc, xenvp, cachefile, sizeof(cachefile)))
+  {
+    if ((cachefd = xcache_open(cachefile, &impressions)) >= 0)
+    {
+      bool	ret;			// Return value
+
+      // Sending the cached output doesn't need the slot...
+      xsched_release();
+
+      ret = xcache_send(job, device, cachefd, impressions);
+
+      close(cachefd);
+
+      while (xenvc > penv->envc)
+        free(xenvp[-- xenvc]);
+
+      xenv_release(penv);
+
+      return (ret);
+    }
+  }
+  else
+  {
+    cachefile[0] = '\0';
+  }
+
+  // Run the program...
+  if ((xstdin = open("/dev/null", O_RDONLY)) < 0)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to open /dev/null: %s", strerror(errno));
+    goto transform_failure;
+  }
+
   if (pipe(xstdout))
   {
     papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to create pipe for stdout: %s", strerror(errno));
     goto transform_failure;
   }
 
+#ifdef F_SETPIPE_SZ
+  // Use a large pipe so that ipptransform can keep converting while the
+  // device is busy, and read it all at once...
+  if ((i = (size_t)fcntl(xstdout[0], F_SETPIPE_SZ, LOCAL_XPIPE_SIZE)) > datasize && i <= LOCAL_XPIPE_SIZE)
+    datasize = i;
+#endif // F_SETPIPE_SZ
+
+  if ((data = malloc(datasize)) == NULL)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for transform output: %s", strerror(errno));
+    goto transform_failure;
+  }
+
   if (pipe(xstderr))
   {
     papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to create pipe for stderr: %s", strerror(errno));
     goto transform_failure;
   }
 
-  posix_spawn_file_actions_init(&xactions);
-  posix_spawn_file_actions_addopen(&xactions, 0, "/dev/null", O_RDONLY, 0);
-  posix_spawn_file_actions_adddup2(&xactions, xstdout[1], 1);
-  posix_spawn_file_actions_adddup2(&xactions, xstderr[1], 2);
+  if (cachefile[0])
+  {
+    // Save the output for the next time...
+    local_xcache_t	header;		// Cache file header
+
+    memset(&header, 0, sizeof(header));
+
+    snprintf(cachetemp, sizeof(cachetemp), "%s.XXXXXX", cachefile);
+    if ((cachefd = mkstemp(cachetemp)) >= 0 && !write_all(cachefd, &header, sizeof(header)))
+    {
+      close(cachefd);
+      unlink(cachetemp);
+      cachefd = -1;
+    }
+  }
+
+  xfds[0] = xstdin;
+  xfds[1] = xstdout[1];
+  xfds[2] = xstderr[1];
 
-  if (posix_spawn(&xpid, "ipptransform", &xactions, NULL, (char * const *)xargv, xenvp))
+  spawn_start = cupsGetClock();
+
+  if ((worker = worker_acquire(job)) != NULL)
   {
-    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to start 'ipptransform' command: %s", strerror(errno));
-    posix_spawn_file_actions_destroy(&xactions);
+    // Have a worker start the command...
+    if ((xpid = worker_spawn(worker, xargv, xenvc, xenvp, xfds)) > 0)
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Started 'ipptransform' command using worker %d, pid=%d", (int)worker->pid, (int)xpid);
+    }
+    else
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_WARN, "Unable to start 'ipptransform' command using worker %d.", (int)worker->pid);
+      worker_release(worker, true);
+      worker = NULL;
+    }
+  }
 
-    goto transform_failure;
+  if (!worker)
+  {
+    // Spawn the command directly...
+    char			**spawnenv;
+					// Environment for command
+    size_t			spawnenvc;
+					// Number of environment variables
+    posix_spawn_file_actions_t	xactions;
+					// File actions
+
+    for (spawnenvc = 0; environ[spawnenvc]; spawnenvc ++);
+
+    if ((spawnenv = calloc(spawnenvc + xenvc + 1, sizeof(char *))) == NULL)
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for transform environment: %s", strerror(errno));
+      goto transform_failure;
+    }
+
+    memcpy(spawnenv, environ, spawnenvc * sizeof(char *));
+    memcpy(spawnenv + spawnenvc, xenvp, xenvc * sizeof(char *));
+
+    posix_spawn_file_actions_init(&xactions);
+    posix_spawn_file_actions_adddup2(&xactions, xstdin, 0);
+    posix_spawn_file_actions_adddup2(&xactions, xstdout[1], 1);
+    posix_spawn_file_actions_adddup2(&xactions, xstderr[1], 2);
+
+    if (posix_spawn(&xpid, "ipptransform", &xactions, NULL, (char * const *)xargv, spawnenv))
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to start 'ipptransform' command: %s", strerror(errno));
+      posix_spawn_file_actions_destroy(&xactions);
+      free(spawnenv);
+
+      goto transform_failure;
+    }
+
+    papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Started 'ipptransform' command, pid=%d", (int)xpid);
+
+    posix_spawn_file_actions_destroy(&xactions);
+    free(spawnenv);
   }
 
-  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Started 'ipptransform' command, pid=%d", (int)xpid);
+  LocalMetricsAdd(LOCAL_METRIC_TRANSFORM_SPAWN, 1, cupsGetClock() - spawn_start);
 
   // Free memory used for command...
-  posix_spawn_file_actions_destroy(&xactions);
-
-  while (xenvc > 0)
+  while (xenvc > penv->envc)
     free(xenvp[-- xenvc]);
 
+  xenv_release(penv);
+
   // Read from the stdout and stderr pipes until EOF...
+  close(xstdin);
   close(xstdout[1]);
   close(xstderr[1]);
 
@@ -246,18 +442,80 @@ LocalTransformFilter(
   polldata[1].fd     = xstderr[0];
   polldata[1].events = POLLIN;
 
-  while (poll(polldata, (nfds_t)2, -1) > 0)
+  // Send output to the device as soon as it is available and keep going
+  // until both pipes are closed, since the last output can arrive with the
+  // hangup...
+  start = cupsGetClock();
+
+  papplDeviceGetMetrics(device, &devmetrics);
+
+  while (polldata[0].fd >= 0 || polldata[1].fd >= 0)
   {
-    if (polldata[0].revents & POLLIN)
+    if (poll(polldata, (nfds_t)2, 1000) < 0)
+    {
+      if (errno == EINTR || errno == EAGAIN)
+        continue;
+
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to read from ipptransform command: %s", strerror(errno));
+      break;
+    }
+
+    if (!canceled && papplJobIsCanceled(job))
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Stopping ipptransform command, pid=%d", (int)xpid);
+      kill(xpid, SIGTERM);
+      canceled = true;
+    }
+
+    if (polldata[0].revents)
     {
-      if ((bytes = read(xstdout[0], data, sizeof(data))) > 0)
-	papplDeviceWrite(device, data, (size_t)bytes);
+      if ((bytes = read(xstdout[0], data, datasize)) > 0)
+      {
+	if (write_error)
+	{
+	  // Discard output until ipptransform exits...
+	}
+	else if (papplDeviceWrite(device, data, (size_t)bytes) < 0)
+	{
+	  papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to send print data to printer.");
+	  kill(xpid, SIGTERM);
+	  write_error = true;
+	}
+	else
+	{
+	  total += (size_t)bytes;
+
+	  if (cachefd >= 0 && (total > LocalTransformCache / 4 || !write_all(cachefd, data, (size_t)bytes)))
+	  {
+	    // Too large or unable to write, don't cache...
+	    close(cachefd);
+	    unlink(cachetemp);
+	    cachefd = -1;
+	  }
+	}
+      }
+      else if (bytes == 0 || (errno != EINTR && errno != EAGAIN))
+      {
+        polldata[0].fd = -1;
+      }
     }
 
-    if (polldata[1].revents & POLLIN)
+    if (polldata[1].revents)
     {
       // Message on stderr - log message or update progress...
-      if ((bytes = read(xstderr[0], endptr, sizeof(line) - (size_t)(endptr - line) - 1)) > 0)
+      if (endptr >= (line + sizeof(line) - 1))
+      {
+        // Line too long, log what we have...
+	papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "%s", line);
+	endptr = line;
+      }
+
+      if ((bytes = read(xstderr[0], endptr, sizeof(line) - (size_t)(endptr - line) - 1)) <= 0)
+      {
+        if (bytes == 0 || (errno != EINTR && errno != EAGAIN))
+          polldata[1].fd = -1;
+      }
+      else
       {
 	endptr += bytes;
 	*endptr = '\0';
@@ -285,7 +543,7 @@ LocalTransformFilter(
 	  if (!strncmp(line, "ATTR:", 5))
 	  {
 	    // Process job attribute update.
-	    process_attr_message(job, valptr);
+	    process_attr_message(job, valptr, &impressions);
 	  }
 	  else if (!strncmp(line, "ERROR:", 6))
 	  {
@@ -317,16 +575,72 @@ LocalTransformFilter(
 	}
       }
     }
-
-    if ((polldata[0].revents & POLLHUP) || (polldata[1].revents & POLLHUP))
-      break;
   }
 
   close(xstdout[0]);
   close(xstderr[0]);
+  free(data);
+
+  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Sent %lu bytes of transform output in %.3f seconds.", (unsigned long)total, cupsGetClock() - start);
+
+  LocalMetricsAddDevice(device, &devmetrics);
 
   // Wait for child to complete...
-  while (waitpid(xpid, &xstatus, 0) < 0);
+  if (worker)
+  {
+    // Get the exit status from the worker...
+    if (!read_all(worker->fd, &xstatus, sizeof(xstatus)))
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Lost transform worker %d.", (int)worker->pid);
+      worker_release(worker, true);
+      xsched_release();
+
+      if (cachefd >= 0)
+      {
+        close(cachefd);
+        unlink(cachetemp);
+      }
+
+      return (false);
+    }
+
+    worker_release(worker, false);
+  }
+  else
+  {
+    while (waitpid(xpid, &xstatus, 0) < 0);
+  }
+
+  xsched_release();
+
+  LocalMetricsAdd(LOCAL_METRIC_TRANSFORM_TIME, 1, cupsGetClock() - start);
+
+  if (cachefd >= 0)
+  {
+    // Finish the cache file, writing the header last so that only complete
+    // output is used...
+    local_xcache_t	header;		// Cache file header
+    bool		saved;		// Was the output saved?
+
+    memcpy(header.magic, LOCAL_XCACHE_MAGIC, sizeof(header.magic));
+    header.impressions = impressions;
+
+    saved = !xstatus && !write_error && !canceled && pwrite(cachefd, &header, sizeof(header), 0) == (ssize_t)sizeof(header);
+
+    if (close(cachefd))
+      saved = false;
+
+    if (saved && !rename(cachetemp, cachefile))
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Saved transform output to cache.");
+      LocalMetricsAdd(LOCAL_METRIC_TRANSFORM_CACHE_STORE, 1, (double)total);
+      xcache_evict();
+    }
+    else
+    {
+      unlink(cachetemp);
+    }
+  }
 
   if (xstatus)
   {
@@ -336,11 +650,14 @@ LocalTransformFilter(
       papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "ipptransform command crashed on signal %d.", WTERMSIG(xstatus));
   }
 
-  return (xstatus ? true : false);
+  return (xstatus || write_error ? false : true);
 
   // This is where we go for hard failures...
   transform_failure:
 
+  if (xstdin >= 0)
+    close(xstdin);
+
   if (xstdout[0] >= 0)
     close(xstdout[0]);
   if (xstdout[1] >= 0)
@@ -351,14 +668,47 @@ LocalTransformFilter(
   if (xstderr[1] >= 0)
     close(xstderr[1]);
 
-  while (xenvc > 0)
+  while (xenvc > penv->envc)
     free(xenvp[-- xenvc]);
 
+  xenv_release(penv);
+
+  free(data);
+
+  if (cachefd >= 0)
+  {
+    close(cachefd);
+    unlink(cachetemp);
+  }
+
+  if (scheduled)
+    xsched_release();
+
   return (false);
 
 }
 
 
+//
+// 'LocalTransformTimer()' - Stop idle transform workers.
+//
+
+bool					// O - `true` to keep the timer running
+LocalTransformTimer(
+    pappl_system_t *system,		// I - System (not used)
+    void           *data)		// I - Callback data (not used)
+{
+  (void)system;
+  (void)data;
+
+  cupsMutexLock(&worker_mutex);
+  worker_expire(time(NULL));
+  cupsMutexUnlock(&worker_mutex);
+
+  return (true);
+}
+
+
 //
 // 'process_attr_message()' - Process an ATTR: message from the ipptransform
 //                            command.
@@ -367,7 +717,8 @@ LocalTransformFilter(
 static void
 process_attr_message(
     pappl_job_t *job,			// I - Job
-    char        *message)		// I - Message
+    char        *message,		// I - Message
+    int         *impressions)		// IO - Number of impressions
 {
   size_t	num_options = 0;	// Number of name=value pairs
   cups_option_t	*options = NULL;	// name=value pairs from message
@@ -378,10 +729,1145 @@ process_attr_message(
   num_options = cupsParseOptions(message, /*end*/NULL, num_options, &options);
 
   if ((value = cupsGetIntegerOption("job-impressions", num_options, options)) > 0)
+  {
     papplJobSetImpressions(job, value);
+    *impressions = value;
+  }
 
   if ((value = cupsGetIntegerOption("job-impressions-completed", num_options, options)) > 0)
     papplJobSetImpressionsCompleted(job, value);
 
   cupsFreeOptions(num_options, options);
 }
+
+
+//
+// 'read_all()' - Read an exact number of bytes from a file descriptor.
+//
+// This function is async-signal-safe so it can be used by worker processes.
+//
+
+static bool				// O - `true` on success, `false` on EOF/error
+read_all(int    fd,			// I - File descriptor
+         void   *buffer,		// I - Buffer
+         size_t bytes)			// I - Number of bytes to read
+{
+  char		*ptr = (char *)buffer;	// Pointer into buffer
+  ssize_t	rbytes;			// Bytes read
+
+
+  while (bytes > 0)
+  {
+    if ((rbytes = read(fd, ptr, bytes)) < 0)
+    {
+      if (errno == EINTR || errno == EAGAIN)
+        continue;
+
+      return (false);
+    }
+    else if (rbytes == 0)
+    {
+      return (false);
+    }
+
+    ptr   += rbytes;
+    bytes -= (size_t)rbytes;
+  }
+
+  return (true);
+}
+
+
+//
+// 'worker_acquire()' - Get an idle transform worker, starting one as needed.
+//
+// `NULL` is returned when the pool is disabled, all workers are busy, or a new
+// worker cannot be started, in which case the caller spawns ipptransform
+// directly.
+//
+
+static local_worker_t *			// O - Worker or `NULL` for none
+worker_acquire(pappl_job_t *job)	// I - Job
+{
+  size_t	i,			// Looping var
+		count;			// Number of pool slots
+  local_worker_t *worker = NULL,	// Available worker
+		*unused = NULL;		// Unused slot
+  time_t	curtime = time(NULL);	// Current time
+  int		sv[2],			// Control socket pair
+		maxfd;			// Maximum file descriptor to close
+  pid_t		pid;			// Worker process ID
+
+
+  if ((count = (size_t)LocalTransformWorkers) > LOCAL_MAX_WORKERS)
+    count = LOCAL_MAX_WORKERS;
+
+  cupsMutexLock(&worker_mutex);
+
+  worker_expire(curtime);
+
+  for (i = 0; i < count; i ++)
+  {
+    local_worker_t *w = workers + i;	// Current worker
+
+    if (w->busy)
+      continue;
+
+    if (w->pid && !worker)
+      worker = w;
+    else if (!w->pid && !unused)
+      unused = w;
+  }
+
+  if (!worker && unused)
+  {
+    // Start a new worker process...
+    if ((maxfd = (int)sysconf(_SC_OPEN_MAX)) < 0 || maxfd > 65536)
+      maxfd = 65536;
+
+    // Create the control socket as close-on-exec so that commands spawned by
+    // other threads don't inherit it...
+#ifdef SOCK_CLOEXEC
+    if (socketpair(AF_LOCAL, SOCK_STREAM | SOCK_CLOEXEC, 0, sv))
+#else
+    if (socketpair(AF_LOCAL, SOCK_STREAM, 0, sv) || fcntl(sv[0], F_SETFD, FD_CLOEXEC) || fcntl(sv[1], F_SETFD, FD_CLOEXEC))
+#endif // SOCK_CLOEXEC
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_WARN, "Unable to create transform worker socket: %s", strerror(errno));
+    }
+    else if ((pid = fork()) == 0)
+    {
+      // Child comes here, close everything but the control socket...
+      int	fd;			// Looping var
+
+      if (sv[1] != 3)
+      {
+        dup2(sv[1], 3);
+        close(sv[1]);
+      }
+
+      fcntl(3, F_SETFD, 0);
+
+      for (fd = 4; fd < maxfd; fd ++)
+        close(fd);
+
+      worker_main(3);
+    }
+    else if (pid < 0)
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_WARN, "Unable to start transform worker: %s", strerror(errno));
+      close(sv[0]);
+      close(sv[1]);
+    }
+    else
+    {
+      // Parent comes here...
+      close(sv[1]);
+
+      unused->pid = pid;
+      unused->fd  = sv[0];
+      worker      = unused;
+
+      papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Started transform worker %d.", (int)pid);
+    }
+  }
+
+  if (worker)
+  {
+    worker->busy      = true;
+    worker->last_used = curtime;
+  }
+
+  cupsMutexUnlock(&worker_mutex);
+
+  return (worker);
+}
+
+
+//
+// 'worker_expire()' - Stop idle workers and reap workers that have exited.
+//
+// Workers that have been idle for LOCAL_WORKER_IDLE seconds or are no longer
+// in the pool are stopped.  Workers only exit on their own when they fail, so
+// this is the only place that decides when a worker has timed out.  The
+// worker mutex must be held by the caller.
+//
+
+static void
+worker_expire(time_t curtime)		// I - Current time
+{
+  size_t	i,			// Looping var
+		count;			// Number of pool slots
+  local_worker_t *w;			// Current worker
+  int		status;			// Exit status
+
+
+  if ((count = (size_t)LocalTransformWorkers) > LOCAL_MAX_WORKERS)
+    count = LOCAL_MAX_WORKERS;
+
+  for (i = 0, w = workers; i < LOCAL_MAX_WORKERS; i ++, w ++)
+  {
+    if (!w->pid || w->busy)
+      continue;
+
+    if (waitpid(w->pid, &status, WNOHANG) == w->pid)
+    {
+      // Worker failed, just clean up...
+      close(w->fd);
+
+      w->pid = 0;
+      w->fd  = -1;
+    }
+    else if (i >= count || (curtime - w->last_used) >= LOCAL_WORKER_IDLE)
+    {
+      worker_stop(w);
+    }
+  }
+}
+
+
+//
+// 'worker_main()' - Run transform commands on behalf of cupslocald.
+//
+// Worker processes are forked from the (multi-threaded) daemon, so everything
+// here must be async-signal-safe - no stdio, no malloc, and no logging.  Each
+// request provides the arguments, additional environment variables, and the
+// standard I/O file descriptors for one ipptransform command.  The worker
+// replies with the process ID and then the exit status of the command.
+//
+
+static void
+worker_main(int fd)			// I - Control socket
+{
+  local_xmsg_t	xmsg;			// Request header
+  struct msghdr	msg;			// Socket message
+  struct iovec	iov;			// I/O vector for header
+  union
+  {
+    struct cmsghdr hdr;			// Control message header
+    char	buffer[CMSG_SPACE(3 * sizeof(int))];
+					// Control message buffer
+  }		control;		// Control message
+  struct cmsghdr *cmsg;			// Current control message
+  ssize_t	bytes;			// Bytes received
+  int		xfds[3],		// Standard I/O for command
+		xstatus,		// Exit status of command
+		i;			// Looping var
+  size_t	envc,			// Number of inherited environment variables
+		count;			// Number of strings
+  pid_t		xpid;			// Command process ID
+  char		*ptr,			// Pointer into request data
+		*end;			// End of request data
+  static char	data[LOCAL_XMSG_MAX];	// Request data
+  static char	*xargv[64],		// Command-line arguments
+		*xenvp[2048];		// Environment variables
+
+
+  for (envc = 0; environ[envc] && envc < (sizeof(xenvp) / sizeof(xenvp[0]) / 2); envc ++)
+    xenvp[envc] = environ[envc];
+
+  for (;;)
+  {
+    // Wait for the next request and file descriptors - the daemon decides
+    // when the worker is idle and closes the control socket to stop it...
+    memset(&msg, 0, sizeof(msg));
+    memset(&control, 0, sizeof(control));
+
+    iov.iov_base       = &xmsg;
+    iov.iov_len        = sizeof(xmsg);
+    msg.msg_iov        = &iov;
+    msg.msg_iovlen     = 1;
+    msg.msg_control    = control.buffer;
+    msg.msg_controllen = sizeof(control.buffer);
+
+    while ((bytes = recvmsg(fd, &msg, 0)) < 0 && errno == EINTR);
+
+    if (bytes <= 0)
+      _exit(0);
+
+    if ((size_t)bytes < sizeof(xmsg) && !read_all(fd, (char *)&xmsg + bytes, sizeof(xmsg) - (size_t)bytes))
+      _exit(1);
+
+    if ((cmsg = CMSG_FIRSTHDR(&msg)) == NULL || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS || cmsg->cmsg_len != CMSG_LEN(3 * sizeof(int)))
+      _exit(1);
+
+    memcpy(xfds, CMSG_DATA(cmsg), sizeof(xfds));
+
+    if (xmsg.length > sizeof(data) || xmsg.argc < 1 || xmsg.argc >= (sizeof(xargv) / sizeof(xargv[0])) || (envc + xmsg.envc) >= (sizeof(xenvp) / sizeof(xenvp[0])) || !read_all(fd, data, xmsg.length))
+      _exit(1);
+
+    // Split the request data into arguments and environment variables...
+    for (ptr = data, end = data + xmsg.length, count = 0; ptr < end && count < (xmsg.argc + xmsg.envc); count ++)
+    {
+      if (count < xmsg.argc)
+        xargv[count] = ptr;
+      else
+        xenvp[envc + count - xmsg.argc] = ptr;
+
+      while (ptr < end && *ptr)
+        ptr ++;
+
+      if (ptr >= end)
+        _exit(1);
+
+      ptr ++;
+    }
+
+    if (count < (xmsg.argc + xmsg.envc))
+      _exit(1);
+
+    xargv[xmsg.argc]       = NULL;
+    xenvp[envc + xmsg.envc] = NULL;
+
+    // Run the command...
+    if ((xpid = fork()) == 0)
+    {
+      // Child comes here...
+      for (i = 0; i < 3; i ++)
+      {
+        if (xfds[i] != i)
+          dup2(xfds[i], i);
+      }
+
+      for (i = 0; i < 3; i ++)
+      {
+        if (xfds[i] > 2)
+          close(xfds[i]);
+      }
+
+      close(fd);
+
+      execve(xargv[0], xargv, xenvp);
+      _exit(127);
+    }
+
+    for (i = 0; i < 3; i ++)
+      close(xfds[i]);
+
+    // Send the process ID, then the exit status when the command finishes...
+    if (write(fd, &xpid, sizeof(xpid)) != (ssize_t)sizeof(xpid))
+      _exit(1);
+
+    if (xpid < 0)
+      continue;
+
+    while (waitpid(xpid, &xstatus, 0) < 0 && errno == EINTR);
+
+    if (write(fd, &xstatus, sizeof(xstatus)) != (ssize_t)sizeof(xstatus))
+      _exit(1);
+  }
+}
+
+
+//
+// 'worker_release()' - Return a worker to the pool.
+//
+
+static void
+worker_release(local_worker_t *worker,	// I - Worker
+               bool           stop)	// I - Stop the worker?
+{
+  cupsMutexLock(&worker_mutex);
+
+  if (stop)
+    worker_stop(worker);
+
+  worker->busy      = false;
+  worker->last_used = time(NULL);
+
+  cupsMutexUnlock(&worker_mutex);
+}
+
+
+//
+// 'worker_spawn()' - Start a transform command using a worker.
+//
+
+static pid_t				// O - Process ID or `-1` on error
+worker_spawn(local_worker_t     *worker,// I - Worker
+             const char * const *argv,	// I - Command-line arguments
+             size_t             envc,	// I - Number of environment variables
+             char * const       *envp,	// I - Environment variables
+             int                fds[3])	// I - Standard I/O file descriptors
+{
+  local_xmsg_t	xmsg;			// Request header
+  struct msghdr	msg;			// Socket message
+  struct iovec	iov[2];			// I/O vectors for header and data
+  union
+  {
+    struct cmsghdr hdr;			// Control message header
+    char	buffer[CMSG_SPACE(3 * sizeof(int))];
+					// Control message buffer
+  }		control;		// Control message
+  struct cmsghdr *cmsg;			// Control message
+  char		*data,			// Request data
+		*ptr;			// Pointer into request data
+  size_t	i,			// Looping var
+		len;			// Length of string
+  ssize_t	bytes;			// Bytes sent
+  pid_t		pid = -1;		// Process ID
+
+
+  // Build the request data...
+  if ((data = malloc(LOCAL_XMSG_MAX)) == NULL)
+    return (-1);
+
+  memset(&xmsg, 0, sizeof(xmsg));
+
+  for (ptr = data, i = 0; argv[i]; i ++, xmsg.argc ++)
+  {
+    if ((len = strlen(argv[i]) + 1) > (size_t)(data + LOCAL_XMSG_MAX - ptr))
+      goto done;
+
+    memcpy(ptr, argv[i], len);
+    ptr += len;
+  }
+
+  for (i = 0; i < envc; i ++, xmsg.envc ++)
+  {
+    if ((len = strlen(envp[i]) + 1) > (size_t)(data + LOCAL_XMSG_MAX - ptr))
+      goto done;
+
+    memcpy(ptr, envp[i], len);
+    ptr += len;
+  }
+
+  xmsg.length = (size_t)(ptr - data);
+
+  // Send the request along with the standard I/O file descriptors...
+  memset(&msg, 0, sizeof(msg));
+  memset(&control, 0, sizeof(control));
+
+  iov[0].iov_base    = &xmsg;
+  iov[0].iov_len     = sizeof(xmsg);
+  iov[1].iov_base    = data;
+  iov[1].iov_len     = xmsg.length;
+  msg.msg_iov        = iov;
+  msg.msg_iovlen     = 2;
+  msg.msg_control    = control.buffer;
+  msg.msg_controllen = sizeof(control.buffer);
+
+  cmsg             = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type  = SCM_RIGHTS;
+  cmsg->cmsg_len   = CMSG_LEN(3 * sizeof(int));
+  memcpy(CMSG_DATA(cmsg), fds, 3 * sizeof(int));
+
+#ifdef MSG_NOSIGNAL
+  while ((bytes = sendmsg(worker->fd, &msg, MSG_NOSIGNAL)) < 0 && errno == EINTR);
+#else
+  while ((bytes = sendmsg(worker->fd, &msg, 0)) < 0 && errno == EINTR);
+#endif // MSG_NOSIGNAL
+
+  if (bytes < 0)
+    goto done;
+
+  // Send any data that didn't fit in the initial message...
+  if ((size_t)bytes < sizeof(xmsg))
+    goto done;
+
+  for (ptr = data + (size_t)bytes - sizeof(xmsg); ptr < (data + xmsg.length); ptr += bytes)
+  {
+    if ((bytes = write(worker->fd, ptr, (size_t)(data + xmsg.length - ptr))) < 0)
+    {
+      if (errno == EINTR || errno == EAGAIN)
+      {
+        bytes = 0;
+        continue;
+      }
+
+      goto done;
+    }
+  }
+
+  // Get the process ID for the command...
+  if (!read_all(worker->fd, &pid, sizeof(pid)))
+    pid = -1;
+
+  done:
+
+  free(data);
+
+  return (pid);
+}
+
+
+//
+// 'worker_stop()' - Stop a worker process.
+//
+// The worker mutex must be held by the caller.
+//
+
+static void
+worker_stop(local_worker_t *worker)	// I - Worker
+{
+  int	status;				// Exit status
+
+
+  if (!worker->pid)
+    return;
+
+  // Closing the control socket tells the worker to exit...
+  close(worker->fd);
+
+  while (waitpid(worker->pid, &status, 0) < 0 && errno == EINTR);
+
+  worker->pid = 0;
+  worker->fd  = -1;
+}
+
+
+//
+// 'write_all()' - Write an exact number of bytes to a file descriptor.
+//
+
+static bool				// O - `true` on success, `false` on error
+write_all(int        fd,		// I - File descriptor
+          const void *buffer,		// I - Buffer
+          size_t     bytes)		// I - Number of bytes to write
+{
+  const char	*ptr = (const char *)buffer;
+					// Pointer into buffer
+  ssize_t	wbytes;			// Bytes written
+
+
+  while (bytes > 0)
+  {
+    if ((wbytes = write(fd, ptr, bytes)) < 0)
+    {
+      if (errno == EINTR || errno == EAGAIN)
+        continue;
+
+      return (false);
+    }
+
+    ptr   += wbytes;
+    bytes -= (size_t)wbytes;
+  }
+
+  return (true);
+}
+
+
+//
+// 'xcache_compare()' - Compare the last use times of two cache entries.
+//
+
+static int				// O - Result of comparison
+xcache_compare(local_xcentry_t *a,	// I - First entry
+               local_xcentry_t *b)	// I - Second entry
+{
+  if (a->mtime < b->mtime)
+    return (-1);
+  else if (a->mtime > b->mtime)
+    return (1);
+  else
+    return (strcmp(a->filename, b->filename));
+}
+
+
+//
+// 'xcache_evict()' - Remove the least recently used cache files.
+//
+// Cache files are removed, oldest first, until the total size is no more than
+// "LocalTransformCache" bytes.  Temporary files that have not been written to
+// for LOCAL_XCACHE_STALE seconds are left over from a crash and are removed.
+//
+
+static void
+xcache_evict(void)
+{
+  DIR			*dir;		// Spool directory
+  struct dirent		*dent;		// Directory entry
+  struct stat		fileinfo;	// File information
+  char			filename[1024];	// Cache filename
+  local_xcentry_t	*entries = NULL,// Cache entries
+			*entry;		// Current entry
+  size_t		i,		// Looping var
+			num_entries = 0,// Number of entries
+			alloc_entries = 0;
+					// Allocated entries
+  off_t			total = 0;	// Total size of cache
+
+
+  cupsMutexLock(&xcache_mutex);
+
+  if ((dir = opendir(LocalSpoolDir)) == NULL)
+  {
+    cupsMutexUnlock(&xcache_mutex);
+    return;
+  }
+
+  while ((dent = readdir(dir)) != NULL)
+  {
+    const char *ext = strstr(dent->d_name, ".out");
+					// Extension
+
+    if (strncmp(dent->d_name, "transform-", 10) || !ext || (ext[4] && ext[4] != '.'))
+      continue;
+
+    snprintf(filename, sizeof(filename), "%s/%s", LocalSpoolDir, dent->d_name);
+    if (stat(filename, &fileinfo))
+      continue;
+
+    if (ext[4])
+    {
+      // Temporary "transform-HASH.out.XXXXXX" file, remove it if it was left
+      // behind by a crash...
+      if ((time(NULL) - fileinfo.st_mtime) >= LOCAL_XCACHE_STALE)
+        unlink(filename);
+      else
+        total += fileinfo.st_size;
+      continue;
+    }
+
+    if (num_entries >= alloc_entries)
+    {
+      if ((entry = realloc(entries, (alloc_entries + 64) * sizeof(local_xcentry_t))) == NULL)
+        break;
+
+      entries       = entry;
+      alloc_entries += 64;
+    }
+
+    if ((entries[num_entries].filename = strdup(filename)) == NULL)
+      break;
+
+    entries[num_entries].size  = fileinfo.st_size;
+    entries[num_entries].mtime = fileinfo.st_mtime;
+    total += fileinfo.st_size;
+    num_entries ++;
+  }
+
+  closedir(dir);
+
+  if (total > (off_t)LocalTransformCache)
+  {
+    qsort(entries, num_entries, sizeof(local_xcentry_t), (int (*)(const void *, const void *))xcache_compare);
+
+    for (i = 0, entry = entries; i < num_entries && total > (off_t)LocalTransformCache; i ++, entry ++)
+    {
+      if (!unlink(entry->filename))
+        total -= entry->size;
+    }
+  }
+
+  for (i = 0; i < num_entries; i ++)
+    free(entries[i].filename);
+  free(entries);
+
+  cupsMutexUnlock(&xcache_mutex);
+}
+
+
+//
+// 'xcache_key()' - Get the cache filename for a document.
+//
+// The cache file for a document is "SPOOLDIR/transform-HASH.out", where HASH
+// is the SHA-256 hash of the document's SHA-256 hash and the environment
+// variables for ipptransform, which include the output type and the Job and
+// Printer attributes that affect the output.
+//
+
+static bool				// O - `true` on success, `false` on error
+xcache_key(pappl_job_t  *job,		// I - Job
+           int          doc_number,	// I - Document number
+           size_t       envc,		// I - Number of environment variables
+           char * const *envp,		// I - Environment variables
+           char         *filename,	// I - Cache filename buffer
+           size_t       filesize)	// I - Size of cache filename buffer
+{
+  int		fd;			// Document file
+  struct stat	fileinfo;		// Document information
+  void		*docdata;		// Document data
+  unsigned char	hash[32];		// SHA-256 hash
+  char		hashstr[65],		// Hash as a hex string
+		*key,			// Cache key string
+		*keyptr;		// Pointer into key
+  size_t	i,			// Looping var
+		keysize;		// Size of key string
+  bool		ret = false;		// Return value
+
+
+  // Hash the document...
+  if ((fd = open(papplJobGetDocumentFilename(job, doc_number), O_RDONLY)) < 0)
+    return (false);
+
+  if (fstat(fd, &fileinfo) || fileinfo.st_size <= 0 || (docdata = mmap(NULL, (size_t)fileinfo.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
+  {
+    close(fd);
+    return (false);
+  }
+
+  if (cupsHashData("sha2-256", docdata, (size_t)fileinfo.st_size, hash, sizeof(hash)) > 0)
+    ret = true;
+
+  munmap(docdata, (size_t)fileinfo.st_size);
+  close(fd);
+
+  if (!ret)
+    return (false);
+
+  // Then hash the document hash and environment...
+  cupsHashString(hash, sizeof(hash), hashstr, sizeof(hashstr));
+
+  for (i = 0, keysize = sizeof(hashstr); i < envc; i ++)
+    keysize += strlen(envp[i]) + 1;
+
+  if ((key = malloc(keysize)) == NULL)
+    return (false);
+
+  cupsCopyString(key, hashstr, keysize);
+  for (i = 0, keyptr = key + strlen(key); i < envc; i ++)
+  {
+    *keyptr++ = '\n';
+    cupsCopyString(keyptr, envp[i], keysize - (size_t)(keyptr - key));
+    keyptr += strlen(keyptr);
+  }
+
+  ret = cupsHashData("sha2-256", key, (size_t)(keyptr - key), hash, sizeof(hash)) > 0;
+
+  free(key);
+
+  if (ret)
+    snprintf(filename, filesize, "%s/transform-%s.out", LocalSpoolDir, cupsHashString(hash, sizeof(hash), hashstr, sizeof(hashstr)));
+
+  return (ret);
+}
+
+
+//
+// 'xcache_open()' - Open a cache file.
+//
+// The modification time of the cache file is updated so that the most recently
+// used files are kept when evicting.
+//
+
+static int				// O - File descriptor or `-1` if not cached
+xcache_open(const char *filename,	// I - Cache filename
+            int        *impressions)	// O - Number of impressions
+{
+  int			fd;		// Cache file
+  local_xcache_t	header;		// Cache file header
+
+
+  if ((fd = open(filename, O_RDONLY)) < 0)
+    return (-1);
+
+  if (!read_all(fd, &header, sizeof(header)) || memcmp(header.magic, LOCAL_XCACHE_MAGIC, sizeof(header.magic)))
+  {
+    close(fd);
+    unlink(filename);
+    return (-1);
+  }
+
+  futimens(fd, NULL);
+
+  *impressions = header.impressions;
+
+  return (fd);
+}
+
+
+//
+// 'xcache_send()' - Send a cache file to the device.
+//
+
+static bool				// O - `true` on success, `false` on failure
+xcache_send(pappl_job_t    *job,	// I - Job
+            pappl_device_t *device,	// I - Output device
+            int            fd,		// I - Cache file
+            int            impressions)	// I - Number of impressions
+{
+  char			buffer[65536];	// Copy buffer
+  ssize_t		bytes;		// Bytes read
+  size_t		total = 0;	// Total bytes sent
+  double		start = cupsGetClock();
+					// Start time
+  pappl_devmetrics_t	devmetrics;	// Device metrics at start
+
+
+  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Sending cached transform output.");
+
+  if (impressions > 0)
+    papplJobSetImpressions(job, impressions);
+
+  papplDeviceGetMetrics(device, &devmetrics);
+
+  while ((bytes = read(fd, buffer, sizeof(buffer))) != 0)
+  {
+    if (bytes < 0)
+    {
+      if (errno == EINTR || errno == EAGAIN)
+        continue;
+
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to read cached transform output: %s", strerror(errno));
+      return (false);
+    }
+
+    if (papplJobIsCanceled(job))
+      return (false);
+
+    if (papplDeviceWrite(device, buffer, (size_t)bytes) < 0)
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to send print data to printer.");
+      return (false);
+    }
+
+    total += (size_t)bytes;
+  }
+
+  if (impressions > 0)
+    papplJobSetImpressionsCompleted(job, impressions);
+
+  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Sent %lu bytes of cached transform output in %.3f seconds.", (unsigned long)total, cupsGetClock() - start);
+
+  LocalMetricsAddDevice(device, &devmetrics);
+  LocalMetricsAdd(LOCAL_METRIC_TRANSFORM_CACHE_HIT, 1, (double)total);
+
+  return (true);
+}
+
+
+//
+// 'xenv_acquire()' - Get the transform environment for a printer.
+//
+// The environment variables for the printer's driver attributes are built
+// once and then reused until the system configuration changes.  Release the
+// environment with `xenv_release()`.
+//
+
+static local_xenv_t *			// O - Printer environment or `NULL` on error
+xenv_acquire(pappl_printer_t *printer)	// I - Printer
+{
+  int		printer_id = papplPrinterGetID(printer),
+					// Printer ID
+		config_changes = papplSystemGetConfigChanges(papplPrinterGetSystem(printer));
+					// Current configuration changes
+  local_xenv_t	*env,			// Current environment
+		**prev;			// Previous pointer in list
+
+
+  cupsMutexLock(&xenv_mutex);
+
+  for (prev = &xenv_list; (env = *prev) != NULL;)
+  {
+    if (env->config_changes != config_changes)
+    {
+      // Remove out-of-date environments, including those for deleted
+      // printers...
+      *prev = env->next;
+
+      if (env->use == 0)
+        free(env);
+      else
+        env->stale = true;
+    }
+    else if (env->printer_id == printer_id)
+    {
+      break;
+    }
+    else
+    {
+      prev = &env->next;
+    }
+  }
+
+  if (!env && (env = xenv_create(printer, config_changes)) != NULL)
+  {
+    env->next = xenv_list;
+    xenv_list = env;
+  }
+
+  if (env)
+    env->use ++;
+
+  cupsMutexUnlock(&xenv_mutex);
+
+  return (env);
+}
+
+
+//
+// 'xenv_create()' - Build the transform environment for a printer.
+//
+// The environment is allocated as a single block holding the structure, the
+// array of pointers, and the strings.
+//
+
+static local_xenv_t *			// O - Printer environment or `NULL` on error
+xenv_create(pappl_printer_t *printer,	// I - Printer
+            int             config_changes)
+					// I - Current configuration changes
+{
+  pappl_pr_driver_data_t pdata;		// Printer driver data
+  ipp_t			*pattrs;	// Printer driver attributes
+  ipp_attribute_t	*attr;		// Current attribute
+  size_t		i,		// Looping var
+			envc = 0,	// Number of environment variables
+			length = 0;	// Length of strings
+  char			*envp[LOCAL_XENV_MAX],
+					// Temporary environment variables
+			*ptr;		// Pointer into block
+  local_xenv_t		*env = NULL;	// Printer environment
+  char			val[1280];	// IPP_NAME=value
+
+
+  pattrs = papplPrinterGetDriverAttributes(printer);
+  papplPrinterGetDriverData(printer, &pdata);
+
+  if (pdata.format && asprintf(envp + envc, "OUTPUT_TYPE=%s", pdata.format) > 0)
+    envc ++;
+
+  envp[envc ++] = strdup("SERVER_LOGLEVEL=debug");
+
+  // Convert "attribute-name-default" to "IPP_ATTRIBUTE_NAME_DEFAULT=" and
+  // "pwg-xxx" to "IPP_PWG_XXX=", leaving room for the document and job
+  // variables...
+  for (attr = ippGetFirstAttribute(pattrs); attr && envc < (LOCAL_XENV_MAX - 100); attr = ippGetNextAttribute(pattrs))
+  {
+    const char	*name = ippGetName(attr);
+					// Attribute name
+
+    if (strncmp(name, "pwg-", 4) && !strstr(name, "-default"))
+      continue;
+
+    xenv_string(attr, val, sizeof(val));
+    envp[envc ++] = strdup(val);
+  }
+
+  ippDelete(pattrs);
+
+  // Copy everything to a single block...
+  for (i = 0; i < envc; i ++)
+  {
+    if (!envp[i])
+      goto done;
+
+    length += strlen(envp[i]) + 1;
+  }
+
+  if ((env = calloc(1, sizeof(local_xenv_t) + envc * sizeof(char *) + length)) == NULL)
+    goto done;
+
+  env->printer_id     = papplPrinterGetID(printer);
+  env->config_changes = config_changes;
+  env->envc           = envc;
+  env->envp           = (char **)(env + 1);
+
+  for (i = 0, ptr = (char *)(env->envp + envc); i < envc; i ++)
+  {
+    length = strlen(envp[i]) + 1;
+
+    memcpy(ptr, envp[i], length);
+    env->envp[i] = ptr;
+    ptr += length;
+  }
+
+  done:
+
+  for (i = 0; i < envc; i ++)
+    free(envp[i]);
+
+  return (env);
+}
+
+
+//
+// 'xenv_release()' - Release a printer environment.
+//
+
+static void
+xenv_release(local_xenv_t *env)		// I - Printer environment
+{
+  cupsMutexLock(&xenv_mutex);
+
+  if (env->use > 0)
+    env->use --;
+
+  if (env->stale && env->use == 0)
+    free(env);
+
+  cupsMutexUnlock(&xenv_mutex);
+}
+
+
+//
+// 'xenv_string()' - Convert an attribute to an environment variable.
+//
+// "attribute-name" is converted to "IPP_ATTRIBUTE_NAME=" followed by the
+// value(s) of the attribute.
+//
+
+static void
+xenv_string(ipp_attribute_t *attr,	// I - Attribute
+            char            *buffer,	// I - String buffer
+            size_t          bufsize)	// I - Size of string buffer
+{
+  const char	*name = ippGetName(attr);
+					// Attribute name
+  char		*bufptr = buffer,	// Pointer into buffer
+		*bufend = buffer + bufsize - 2;
+					// End of buffer
+
+
+  *bufptr++ = 'I';
+  *bufptr++ = 'P';
+  *bufptr++ = 'P';
+  *bufptr++ = '_';
+  while (*name && bufptr < bufend)
+  {
+    if (*name == '-')
+      *bufptr++ = '_';
+    else
+      *bufptr++ = (char)toupper(*name & 255);
+
+    name ++;
+  }
+  *bufptr++ = '=';
+  ippAttributeString(attr, bufptr, bufsize - (size_t)(bufptr - buffer));
+}
+
+
+//
+// 'xsched_acquire()' - Wait for a transform slot.
+//
+// The number of concurrent transforms is limited to "LocalTransformLimit",
+// or one per CPU by default.  Waiting transforms are started in order of job
+// priority and then document size, so that small jobs are not stuck behind
+// large ones, but any transform that has waited for LOCAL_XSCHED_AGE seconds
+// goes first.
+//
+
+static bool				// O - `true` on success, `false` if canceled
+xsched_acquire(pappl_job_t *job,	// I - Job
+               int         doc_number)	// I - Document number
+{
+  local_xwait_t	wait,			// This transform
+		*current,		// Current waiting transform
+		**prev;			// Previous pointer in list
+  struct stat	fileinfo;		// Document information
+  size_t	limit;			// Maximum number of transforms
+  bool		canceled = false,	// Was the job canceled?
+		waited = false;		// Did we have to wait?
+  double	elapsed;		// Wait time in seconds
+
+
+  if (LocalTransformLimit > 0)
+    limit = (size_t)LocalTransformLimit;
+  else if ((limit = (size_t)sysconf(_SC_NPROCESSORS_ONLN)) < 1)
+    limit = 1;
+
+  wait.priority = papplJobGetPriority(job);
+  wait.size     = stat(papplJobGetDocumentFilename(job, doc_number), &fileinfo) ? 0 : fileinfo.st_size;
+  wait.queued   = cupsGetClock();
+
+  cupsMutexLock(&xsched_mutex);
+
+  wait.next      = xsched_waiting;
+  xsched_waiting = &wait;
+
+  for (;;)
+  {
+    if (xsched_running < limit)
+    {
+      // Start if no other waiting transform should go first...
+      double curtime = cupsGetClock();	// Current time
+
+      for (current = xsched_waiting; current; current = current->next)
+      {
+        if (current != &wait && xsched_before(current, &wait, curtime))
+          break;
+      }
+
+      if (!current)
+        break;
+    }
+
+    if (!waited)
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Waiting for a transform slot (%lu running, %lu allowed).", (unsigned long)xsched_running, (unsigned long)limit);
+      waited = true;
+    }
+
+    cupsCondWait(&xsched_cond, &xsched_mutex, 1.0);
+
+    if ((canceled = papplJobIsCanceled(job)) == true)
+      break;
+  }
+
+  for (prev = &xsched_waiting; *prev; prev = &((*prev)->next))
+  {
+    if (*prev == &wait)
+    {
+      *prev = wait.next;
+      break;
+    }
+  }
+
+  if (!canceled)
+    xsched_running ++;
+
+  // Let the next waiting transform check again...
+  cupsCondBroadcast(&xsched_cond);
+  cupsMutexUnlock(&xsched_mutex);
+
+  elapsed = cupsGetClock() - wait.queued;
+
+  LocalMetricsAdd(LOCAL_METRIC_TRANSFORM_WAIT, 1, elapsed);
+
+  if (waited)
+    papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Waited %.3f seconds for a transform slot.", elapsed);
+
+  return (!canceled);
+}
+
+
+//
+// 'xsched_before()' - Determine whether one waiting transform goes before another.
+//
+
+static bool				// O - `true` if "a" goes first
+xsched_before(local_xwait_t *a,		// I - First transform
+              local_xwait_t *b,		// I - Second transform
+              double        curtime)	// I - Current time
+{
+  bool	a_aged = (curtime - a->queued) >= LOCAL_XSCHED_AGE,
+					// Has "a" waited too long?
+	b_aged = (curtime - b->queued) >= LOCAL_XSCHED_AGE;
+					// Has "b" waited too long?
+
+
+  if (a_aged || b_aged)
+  {
+    if (a_aged != b_aged)
+      return (a_aged);
+  }
+  else if (a->priority != b->priority)
+  {
+    return (a->priority > b->priority);
+  }
+  else if (a->size != b->size)
+  {
+    return (a->size < b->size);
+  }
+
+  return (a->queued < b->queued);
+}
+
+
+//
+// 'xsched_release()' - Free a transform slot.
+//
+
+static void
+xsched_release(void)
+{
+  cupsMutexLock(&xsched_mutex);
+
+  if (xsched_running > 0)
+    xsched_running --;
+
+  cupsCondBroadcast(&xsched_cond);
+  cupsMutexUnlock(&xsched_mutex);
+}